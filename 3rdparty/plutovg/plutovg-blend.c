@@ -3,6 +3,54 @@
 #include <limits.h>
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PLUTOVG_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define PLUTOVG_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PLUTOVG_TARGET_AVX2
+#else
+#define PLUTOVG_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PLUTOVG_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef PLUTOVG_AVX2
+static int cpu_supports_avx2(void)
+{
+#ifdef _MSC_VER
+    static volatile int supported = -1;
+    if(supported < 0)
+    {
+        int info[4];
+        int result = 0;
+        __cpuid(info, 0);
+        if(info[0] >= 7)
+        {
+            __cpuid(info, 1);
+            if((info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6)
+            {
+                __cpuidex(info, 7, 0);
+                result = (info[1] & (1 << 5)) != 0;
+            }
+        }
+
+        supported = result;
+    }
+
+    return supported;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
 #define COLOR_TABLE_SIZE 1024
 typedef struct {
     plutovg_spread_method_t spread;
@@ -34,6 +82,7 @@ typedef struct {
     double dy;
     double l;
     double off;
+    double inc;
 } linear_gradient_values_t;
 
 typedef struct {
@@ -43,9 +92,22 @@ typedef struct {
     double sqrfr;
     double a;
     double inv2a;
+    double inv_a2;
+    double delta_b;
+    double delta_bb;
+    double delta_rxrxryry;
+    double delta_delta_det;
     int extended;
 } radial_gradient_values_t;
 
+typedef struct {
+    double det;
+    double delta_det;
+    double delta_delta_det;
+    double b;
+    double delta_b;
+} radial_gradient_step_t;
+
 static inline uint32_t premultiply_color(const plutovg_color_t* color, double opacity)
 {
     uint32_t alpha = (uint8_t)(color->a * opacity * 255);
@@ -148,25 +210,225 @@ static inline uint32_t gradient_pixel(const gradient_data_t* gradient, double po
     return gradient->colortable[gradient_clamp(gradient, ipos)];
 }
 
-static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+/*
+ * Vector versions of the gradient lookups. Positions are computed for four
+ * or eight pixels at once and wrapped per spread method with masks, which
+ * matches gradient_clamp for every int, including the INT_MIN that NaN and
+ * out of range positions convert to. AVX2 fetches the colors with gathers.
+ */
+#ifdef PLUTOVG_SSE2
+/*
+ * Advances the radial forward differences by two pixels in the same order as
+ * the scalar loop, so the discriminants and therefore the colors are exact.
+ */
+#define RADIAL_STEP2(dets, bs) \
+    do { \
+        double det_ = det, b_ = b; \
+        det += delta_det; \
+        delta_det += step->delta_delta_det; \
+        b += step->delta_b; \
+        dets = _mm_set_pd(det, det_); \
+        bs = _mm_set_pd(b, b_); \
+        det += delta_det; \
+        delta_det += step->delta_delta_det; \
+        b += step->delta_b; \
+    } while(0)
+
+static inline __m128i select_sse2(__m128i mask, __m128i a, __m128i b)
 {
-    double t, inc;
-    double rx = 0, ry = 0;
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
 
-    if(v->l == 0.0)
+static inline __m128i gradient_clamp_sse2(const gradient_data_t* gradient, __m128i ipos)
+{
+    const __m128i last = _mm_set1_epi32(COLOR_TABLE_SIZE - 1);
+    if(gradient->spread == plutovg_spread_method_repeat)
+        return _mm_and_si128(ipos, last);
+    if(gradient->spread == plutovg_spread_method_reflect)
     {
-        t = inc = 0;
+        const __m128i limit = _mm_set1_epi32(COLOR_TABLE_SIZE * 2 - 1);
+        ipos = _mm_and_si128(ipos, limit);
+        return select_sse2(_mm_cmpgt_epi32(ipos, last), _mm_sub_epi32(limit, ipos), ipos);
     }
-    else
+
+    ipos = select_sse2(_mm_cmpgt_epi32(ipos, last), last, ipos);
+    return _mm_andnot_si128(_mm_srai_epi32(ipos, 31), ipos);
+}
+
+static inline void gradient_pixels_sse2(uint32_t* buffer, const gradient_data_t* gradient, __m128i ipos)
+{
+    int32_t index[4];
+    _mm_storeu_si128((__m128i*)index, gradient_clamp_sse2(gradient, ipos));
+    buffer[0] = gradient->colortable[index[0]];
+    buffer[1] = gradient->colortable[index[1]];
+    buffer[2] = gradient->colortable[index[2]];
+    buffer[3] = gradient->colortable[index[3]];
+}
+
+static int fetch_linear_gradient_sse2(uint32_t* buffer, const gradient_data_t* gradient, int t_fixed, int inc_fixed, int length)
+{
+    const __m128i half = _mm_set1_epi32(FIXPT_SIZE / 2);
+    const __m128i step = _mm_set1_epi32(inc_fixed * 4);
+    __m128i t = _mm_add_epi32(_mm_set1_epi32(t_fixed), _mm_set_epi32(inc_fixed * 3, inc_fixed * 2, inc_fixed, 0));
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
     {
-        rx = gradient->matrix.m01 * (y + 0.5) + gradient->matrix.m00 * (x + 0.5) + gradient->matrix.m02;
-        ry = gradient->matrix.m11 * (y + 0.5) + gradient->matrix.m10 * (x + 0.5) + gradient->matrix.m12;
-        t = v->dx * rx + v->dy * ry + v->off;
-        inc = v->dx * gradient->matrix.m00 + v->dy * gradient->matrix.m10;
-        t *= (COLOR_TABLE_SIZE - 1);
-        inc *= (COLOR_TABLE_SIZE - 1);
+        gradient_pixels_sse2(buffer + i, gradient, _mm_srai_epi32(_mm_add_epi32(t, half), FIXPT_BITS));
+        t = _mm_add_epi32(t, step);
     }
 
+    return i;
+}
+
+static int fetch_radial_gradient_sse2(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, radial_gradient_step_t* step, int length)
+{
+    const __m128d scale = _mm_set1_pd(COLOR_TABLE_SIZE - 1);
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d fr = _mm_set1_pd(gradient->radial.fr);
+    const __m128d dr = _mm_set1_pd(v->dr);
+    double det = step->det;
+    double delta_det = step->delta_det;
+    double b = step->b;
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+    {
+        __m128d det0, det1, b0, b1;
+        RADIAL_STEP2(det0, b0);
+        RADIAL_STEP2(det1, b1);
+
+        __m128d w0 = _mm_sub_pd(_mm_sqrt_pd(det0), b0);
+        __m128d w1 = _mm_sub_pd(_mm_sqrt_pd(det1), b1);
+        __m128i ipos0 = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(w0, scale), half));
+        __m128i ipos1 = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(w1, scale), half));
+        gradient_pixels_sse2(buffer + i, gradient, _mm_unpacklo_epi64(ipos0, ipos1));
+        if(v->extended)
+        {
+            __m128d mask0 = _mm_and_pd(_mm_cmpge_pd(det0, zero), _mm_cmpge_pd(_mm_add_pd(fr, _mm_mul_pd(dr, w0)), zero));
+            __m128d mask1 = _mm_and_pd(_mm_cmpge_pd(det1, zero), _mm_cmpge_pd(_mm_add_pd(fr, _mm_mul_pd(dr, w1)), zero));
+            __m128i mask = _mm_castps_si128(_mm_shuffle_ps(_mm_castpd_ps(mask0), _mm_castpd_ps(mask1), _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_si128((__m128i*)(buffer + i), _mm_and_si128(mask, _mm_loadu_si128((const __m128i*)(buffer + i))));
+        }
+    }
+
+    step->det = det;
+    step->delta_det = delta_det;
+    step->b = b;
+    return i;
+}
+#endif
+
+#ifdef PLUTOVG_AVX2
+PLUTOVG_TARGET_AVX2 static inline __m256i gradient_clamp_avx2(const gradient_data_t* gradient, __m256i ipos)
+{
+    const __m256i last = _mm256_set1_epi32(COLOR_TABLE_SIZE - 1);
+    if(gradient->spread == plutovg_spread_method_repeat)
+        return _mm256_and_si256(ipos, last);
+    if(gradient->spread == plutovg_spread_method_reflect)
+    {
+        const __m256i limit = _mm256_set1_epi32(COLOR_TABLE_SIZE * 2 - 1);
+        ipos = _mm256_and_si256(ipos, limit);
+        return _mm256_min_epi32(ipos, _mm256_sub_epi32(limit, ipos));
+    }
+
+    return _mm256_max_epi32(_mm256_min_epi32(ipos, last), _mm256_setzero_si256());
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i gradient_pixels_avx2(const gradient_data_t* gradient, __m256i ipos)
+{
+    return _mm256_i32gather_epi32((const int*)gradient->colortable, gradient_clamp_avx2(gradient, ipos), 4);
+}
+
+PLUTOVG_TARGET_AVX2 static int fetch_linear_gradient_avx2(uint32_t* buffer, const gradient_data_t* gradient, int t_fixed, int inc_fixed, int length)
+{
+    const __m256i half = _mm256_set1_epi32(FIXPT_SIZE / 2);
+    const __m256i step = _mm256_set1_epi32(inc_fixed * 8);
+    __m256i t = _mm256_add_epi32(_mm256_set1_epi32(t_fixed), _mm256_mullo_epi32(_mm256_set1_epi32(inc_fixed), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    int i = 0;
+    for(;i + 8 <= length;i += 8)
+    {
+        __m256i ipos = _mm256_srai_epi32(_mm256_add_epi32(t, half), FIXPT_BITS);
+        _mm256_storeu_si256((__m256i*)(buffer + i), gradient_pixels_avx2(gradient, ipos));
+        t = _mm256_add_epi32(t, step);
+    }
+
+    _mm256_zeroupper();
+    return i;
+}
+
+PLUTOVG_TARGET_AVX2 static int fetch_radial_gradient_avx2(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, radial_gradient_step_t* step, int length)
+{
+    const __m256d scale = _mm256_set1_pd(COLOR_TABLE_SIZE - 1);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d fr = _mm256_set1_pd(gradient->radial.fr);
+    const __m256d dr = _mm256_set1_pd(v->dr);
+    const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    double det = step->det;
+    double delta_det = step->delta_det;
+    double b = step->b;
+    int i = 0;
+    for(;i + 8 <= length;i += 8)
+    {
+        __m128d det0, det1, det2, det3, b0, b1, b2, b3;
+        RADIAL_STEP2(det0, b0);
+        RADIAL_STEP2(det1, b1);
+        RADIAL_STEP2(det2, b2);
+        RADIAL_STEP2(det3, b3);
+
+        __m256d detlo = _mm256_insertf128_pd(_mm256_castpd128_pd256(det0), det1, 1);
+        __m256d dethi = _mm256_insertf128_pd(_mm256_castpd128_pd256(det2), det3, 1);
+        __m256d wlo = _mm256_sub_pd(_mm256_sqrt_pd(detlo), _mm256_insertf128_pd(_mm256_castpd128_pd256(b0), b1, 1));
+        __m256d whi = _mm256_sub_pd(_mm256_sqrt_pd(dethi), _mm256_insertf128_pd(_mm256_castpd128_pd256(b2), b3, 1));
+        __m128i iposlo = _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_mul_pd(wlo, scale), half));
+        __m128i iposhi = _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_mul_pd(whi, scale), half));
+        __m256i pixels = gradient_pixels_avx2(gradient, _mm256_inserti128_si256(_mm256_castsi128_si256(iposlo), iposhi, 1));
+        if(v->extended)
+        {
+            __m256d masklo = _mm256_and_pd(_mm256_cmp_pd(detlo, zero, _CMP_GE_OQ), _mm256_cmp_pd(_mm256_add_pd(fr, _mm256_mul_pd(dr, wlo)), zero, _CMP_GE_OQ));
+            __m256d maskhi = _mm256_and_pd(_mm256_cmp_pd(dethi, zero, _CMP_GE_OQ), _mm256_cmp_pd(_mm256_add_pd(fr, _mm256_mul_pd(dr, whi)), zero, _CMP_GE_OQ));
+            __m128i lo = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(masklo), even));
+            __m128i hi = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(maskhi), even));
+            pixels = _mm256_and_si256(pixels, _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1));
+        }
+
+        _mm256_storeu_si256((__m256i*)(buffer + i), pixels);
+    }
+
+    _mm256_zeroupper();
+    step->det = det;
+    step->delta_det = delta_det;
+    step->b = b;
+    return i;
+}
+#endif
+
+/*
+ * Gradient positions are computed once per span and then advanced per pixel;
+ * everything that only depends on the gradient and its matrix is set up once
+ * per blend in linear_gradient_values_t and radial_gradient_values_t.
+ */
+static inline double linear_gradient_position(const linear_gradient_values_t* v, const gradient_data_t* gradient, int y, int x)
+{
+    if(v->l == 0.0)
+        return 0;
+
+    double rx = gradient->matrix.m01 * (y + 0.5) + gradient->matrix.m00 * (x + 0.5) + gradient->matrix.m02;
+    double ry = gradient->matrix.m11 * (y + 0.5) + gradient->matrix.m10 * (x + 0.5) + gradient->matrix.m12;
+    double t = v->dx * rx + v->dy * ry + v->off;
+    return t * (COLOR_TABLE_SIZE - 1);
+}
+
+static inline int linear_gradient_fixed(const linear_gradient_values_t* v, double t, int length)
+{
+    if(v->inc > -1e-5 && v->inc < 1e-5)
+        return 1;
+    return t + v->inc * length < (double)(INT_MAX >> (FIXPT_BITS + 1)) && t + v->inc * length > (double)(INT_MIN >> (FIXPT_BITS + 1));
+}
+
+static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values_t* v, const gradient_data_t* gradient, double t, int length)
+{
+    double inc = v->inc;
     const uint32_t* end = buffer + length;
     if(inc > -1e-5 && inc < 1e-5)
     {
@@ -174,10 +436,21 @@ static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values
     }
     else
     {
-        if(t + inc * length < (double)(INT_MAX >> (FIXPT_BITS + 1)) && t + inc * length > (double)(INT_MIN >> (FIXPT_BITS + 1)))
+        if(linear_gradient_fixed(v, t, length))
         {
             int t_fixed = (int)(t * FIXPT_SIZE);
             int inc_fixed = (int)(inc * FIXPT_SIZE);
+#ifdef PLUTOVG_SSE2
+            int count;
+#ifdef PLUTOVG_AVX2
+            if(cpu_supports_avx2())
+                count = fetch_linear_gradient_avx2(buffer, gradient, t_fixed, inc_fixed, length);
+            else
+#endif
+                count = fetch_linear_gradient_sse2(buffer, gradient, t_fixed, inc_fixed, length);
+            buffer += count;
+            t_fixed += inc_fixed * count;
+#endif
             while(buffer < end)
             {
                 *buffer = gradient_pixel_fixed(gradient, t_fixed);
@@ -197,75 +470,80 @@ static void fetch_linear_gradient(uint32_t* buffer, const linear_gradient_values
     }
 }
 
-static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+static inline void radial_gradient_start(radial_gradient_step_t* step, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x)
 {
-    if(v->a == 0.0)
-    {
-        memfill32(buffer, 0, length);
-        return;
-    }
-
     double rx = gradient->matrix.m01 * (y + 0.5) + gradient->matrix.m02 + gradient->matrix.m00 * (x + 0.5);
     double ry = gradient->matrix.m11 * (y + 0.5) + gradient->matrix.m12 + gradient->matrix.m10 * (x + 0.5);
 
     rx -= gradient->radial.fx;
     ry -= gradient->radial.fy;
 
-    double inv_a = 1 / (2 * v->a);
-    double delta_rx = gradient->matrix.m00;
-    double delta_ry = gradient->matrix.m10;
-
     double b = 2 * (v->dr * gradient->radial.fr + rx * v->dx + ry * v->dy);
-    double delta_b = 2 * (delta_rx * v->dx + delta_ry * v->dy);
-    double b_delta_b = 2 * b * delta_b;
-    double delta_b_delta_b = 2 * delta_b * delta_b;
-
+    double b_delta_b = 2 * b * v->delta_b;
     double bb = b * b;
-    double delta_bb = delta_b * delta_b;
-
-    b *= inv_a;
-    delta_b *= inv_a;
 
     double rxrxryry = rx * rx + ry * ry;
-    double delta_rxrxryry = delta_rx * delta_rx + delta_ry * delta_ry;
-    double rx_plus_ry = 2 * (rx * delta_rx + ry * delta_ry);
-    double delta_rx_plus_ry = 2 * delta_rxrxryry;
-
-    inv_a *= inv_a;
+    double rx_plus_ry = 2 * (rx * gradient->matrix.m00 + ry * gradient->matrix.m10);
 
-    double det = (bb - 4 * v->a * (v->sqrfr - rxrxryry)) * inv_a;
-    double delta_det = (b_delta_b + delta_bb + 4 * v->a * (rx_plus_ry + delta_rxrxryry)) * inv_a;
-    double delta_delta_det = (delta_b_delta_b + 4 * v->a * delta_rx_plus_ry) * inv_a;
+    step->det = (bb - 4 * v->a * (v->sqrfr - rxrxryry)) * v->inv_a2;
+    step->delta_det = (b_delta_b + v->delta_bb + 4 * v->a * (rx_plus_ry + v->delta_rxrxryry)) * v->inv_a2;
+    step->delta_delta_det = v->delta_delta_det;
+    step->b = b * v->inv2a;
+    step->delta_b = v->delta_b * v->inv2a;
+}
 
-    const uint32_t* end = buffer + length;
+static inline uint32_t radial_gradient_pixel(const radial_gradient_values_t* v, const gradient_data_t* gradient, const radial_gradient_step_t* step)
+{
     if(v->extended)
     {
-        while(buffer < end)
+        uint32_t result = 0;
+        if(step->det >= 0)
         {
-            uint32_t result = 0;
-            if(det >= 0)
-            {
-                double w = sqrt(det) - b;
-                if(gradient->radial.fr + v->dr * w >= 0)
-                    result = gradient_pixel(gradient, w);
-            }
-
-            *buffer = result;
-            det += delta_det;
-            delta_det += delta_delta_det;
-            b += delta_b;
-            ++buffer;
+            double w = sqrt(step->det) - step->b;
+            if(gradient->radial.fr + v->dr * w >= 0)
+                result = gradient_pixel(gradient, w);
         }
+
+        return result;
     }
+
+    return gradient_pixel(gradient, sqrt(step->det) - step->b);
+}
+
+static inline void radial_gradient_advance(radial_gradient_step_t* step)
+{
+    step->det += step->delta_det;
+    step->delta_det += step->delta_delta_det;
+    step->b += step->delta_b;
+}
+
+static void fetch_radial_gradient(uint32_t* buffer, const radial_gradient_values_t* v, const gradient_data_t* gradient, int y, int x, int length)
+{
+    if(v->a == 0.0)
+    {
+        memfill32(buffer, 0, length);
+        return;
+    }
+
+    radial_gradient_step_t step;
+    radial_gradient_start(&step, v, gradient, y, x);
+
+    const uint32_t* end = buffer + length;
+#ifdef PLUTOVG_SSE2
+    int count;
+#ifdef PLUTOVG_AVX2
+    if(cpu_supports_avx2())
+        count = fetch_radial_gradient_avx2(buffer, v, gradient, &step, length);
     else
+#endif
+        count = fetch_radial_gradient_sse2(buffer, v, gradient, &step, length);
+    buffer += count;
+#endif
+
+    while(buffer < end)
     {
-        while(buffer < end)
-        {
-            *buffer++ = gradient_pixel(gradient, sqrt(det) - b);
-            det += delta_det;
-            delta_det += delta_delta_det;
-            b += delta_b;
-        }
+        *buffer++ = radial_gradient_pixel(v, gradient, &step);
+        radial_gradient_advance(&step);
     }
 }
 
@@ -388,6 +666,547 @@ static void composition_destination_out(uint32_t* dest, int length, const uint32
     }
 }
 
+/*
+ * SIMD variants of the composition functions. Every kernel reproduces the
+ * scalar rounding of BYTE_MUL and interpolate_pixel exactly: a channel
+ * product plus its rounding terms never exceeds 0xff7f, so the arithmetic
+ * fits 16-bit lanes, and pixels are summed as 32-bit words like the scalar
+ * code does. Spans shorter than a vector fall back to the narrower path;
+ * AVX2 kernels clear the upper register halves before handing over to SSE2
+ * code, as compilers do not always do so on tail calls.
+ */
+#ifdef PLUTOVG_SSE2
+static inline __m128i byte_mul_sse2(__m128i x, __m128i a)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(0x80);
+    __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(x, zero), _mm_unpacklo_epi8(a, zero));
+    __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(x, zero), _mm_unpackhi_epi8(a, zero));
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), half), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), half), 8);
+    return _mm_packus_epi16(lo, hi);
+}
+
+static inline __m128i interpolate_pixel_sse2(__m128i x, __m128i a, __m128i y, __m128i b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(0x80);
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(x, zero), _mm_unpacklo_epi8(a, zero)), _mm_mullo_epi16(_mm_unpacklo_epi8(y, zero), _mm_unpacklo_epi8(b, zero)));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(x, zero), _mm_unpackhi_epi8(a, zero)), _mm_mullo_epi16(_mm_unpackhi_epi8(y, zero), _mm_unpackhi_epi8(b, zero)));
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), half), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), half), 8);
+    return _mm_packus_epi16(lo, hi);
+}
+
+static inline __m128i alpha_sse2(__m128i x)
+{
+    x = _mm_srli_epi32(x, 24);
+    x = _mm_or_si128(x, _mm_slli_epi32(x, 8));
+    return _mm_or_si128(x, _mm_slli_epi32(x, 16));
+}
+
+static inline __m128i inverse_alpha_sse2(__m128i x)
+{
+    return alpha_sse2(_mm_xor_si128(x, _mm_set1_epi32(-1)));
+}
+
+static inline int all_zero_sse2(__m128i x)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(x, _mm_setzero_si128())) == 0xffff;
+}
+
+static void solid_blend_sse2(uint32_t* dest, int length, uint32_t color, uint32_t ialpha)
+{
+    const __m128i vcolor = _mm_set1_epi32((int)color);
+    const __m128i via = _mm_set1_epi32((int)(ialpha * 0x01010101));
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_add_epi32(vcolor, byte_mul_sse2(d, via)));
+    }
+
+    for(;i < length;i++)
+        dest[i] = color + BYTE_MUL(dest[i], ialpha);
+}
+
+static void solid_mul_sse2(uint32_t* dest, int length, uint32_t a)
+{
+    const __m128i va = _mm_set1_epi32((int)(a * 0x01010101));
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        _mm_storeu_si128((__m128i*)(dest + i), byte_mul_sse2(d, va));
+    }
+
+    for(;i < length;i++)
+        dest[i] = BYTE_MUL(dest[i], a);
+}
+
+static void composition_solid_source_sse2(uint32_t* dest, int length, uint32_t color, uint32_t alpha)
+{
+    if(alpha == 255)
+        memfill32(dest, color, length);
+    else
+        solid_blend_sse2(dest, length, BYTE_MUL(color, alpha), 255 - alpha);
+}
+
+static void composition_solid_source_over_sse2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha != 255) color = BYTE_MUL(color, const_alpha);
+    solid_blend_sse2(dest, length, color, 255 - plutovg_alpha(color));
+}
+
+static void composition_solid_destination_in_sse2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    uint32_t a = plutovg_alpha(color);
+    if(const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    solid_mul_sse2(dest, length, a);
+}
+
+static void composition_solid_destination_out_sse2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    uint32_t a = plutovg_alpha(~color);
+    if(const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    solid_mul_sse2(dest, length, a);
+}
+
+static void composition_source_sse2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    if(const_alpha == 255)
+    {
+        memcpy(dest, src, (size_t)(length) * sizeof(uint32_t));
+        return;
+    }
+
+    const __m128i vca = _mm_set1_epi32((int)(const_alpha * 0x01010101));
+    const __m128i via = _mm_set1_epi32((int)((255 - const_alpha) * 0x01010101));
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        _mm_storeu_si128((__m128i*)(dest + i), interpolate_pixel_sse2(s, vca, d, via));
+    }
+
+    composition_source(dest + i, length - i, src + i, const_alpha);
+}
+
+static void composition_source_over_sse2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    int i = 0;
+    if(const_alpha == 255)
+    {
+        for(;i + 4 <= length;i += 4)
+        {
+            __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+            if(all_zero_sse2(s))
+                continue;
+            __m128i sia = inverse_alpha_sse2(s);
+            if(all_zero_sse2(sia))
+            {
+                _mm_storeu_si128((__m128i*)(dest + i), s);
+                continue;
+            }
+
+            __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+            _mm_storeu_si128((__m128i*)(dest + i), _mm_add_epi32(s, byte_mul_sse2(d, sia)));
+        }
+    }
+    else
+    {
+        const __m128i vca = _mm_set1_epi32((int)(const_alpha * 0x01010101));
+        for(;i + 4 <= length;i += 4)
+        {
+            __m128i s = byte_mul_sse2(_mm_loadu_si128((const __m128i*)(src + i)), vca);
+            __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+            _mm_storeu_si128((__m128i*)(dest + i), _mm_add_epi32(s, byte_mul_sse2(d, inverse_alpha_sse2(s))));
+        }
+    }
+
+    composition_source_over(dest + i, length - i, src + i, const_alpha);
+}
+
+static void composition_destination_in_sse2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    const __m128i vca = _mm_set1_epi32((int)(const_alpha * 0x01010101));
+    const __m128i vcia = _mm_set1_epi32((int)((255 - const_alpha) * 0x01010101));
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+    {
+        __m128i a = alpha_sse2(_mm_loadu_si128((const __m128i*)(src + i)));
+        if(const_alpha != 255) a = _mm_add_epi8(byte_mul_sse2(a, vca), vcia);
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        _mm_storeu_si128((__m128i*)(dest + i), byte_mul_sse2(d, a));
+    }
+
+    composition_destination_in(dest + i, length - i, src + i, const_alpha);
+}
+
+static void composition_destination_out_sse2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    const __m128i vca = _mm_set1_epi32((int)(const_alpha * 0x01010101));
+    const __m128i vcia = _mm_set1_epi32((int)((255 - const_alpha) * 0x01010101));
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+    {
+        __m128i sia = inverse_alpha_sse2(_mm_loadu_si128((const __m128i*)(src + i)));
+        if(const_alpha != 255) sia = _mm_add_epi8(byte_mul_sse2(sia, vca), vcia);
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + i));
+        _mm_storeu_si128((__m128i*)(dest + i), byte_mul_sse2(d, sia));
+    }
+
+    composition_destination_out(dest + i, length - i, src + i, const_alpha);
+}
+#endif
+
+#ifdef PLUTOVG_AVX2
+PLUTOVG_TARGET_AVX2 static inline __m256i byte_mul_avx2(__m256i x, __m256i a)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i half = _mm256_set1_epi16(0x80);
+    __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(x, zero), _mm256_unpacklo_epi8(a, zero));
+    __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(x, zero), _mm256_unpackhi_epi8(a, zero));
+    lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), half), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), half), 8);
+    return _mm256_packus_epi16(lo, hi);
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i interpolate_pixel_avx2(__m256i x, __m256i a, __m256i y, __m256i b)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i half = _mm256_set1_epi16(0x80);
+    __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(x, zero), _mm256_unpacklo_epi8(a, zero)), _mm256_mullo_epi16(_mm256_unpacklo_epi8(y, zero), _mm256_unpacklo_epi8(b, zero)));
+    __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(x, zero), _mm256_unpackhi_epi8(a, zero)), _mm256_mullo_epi16(_mm256_unpackhi_epi8(y, zero), _mm256_unpackhi_epi8(b, zero)));
+    lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), half), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), half), 8);
+    return _mm256_packus_epi16(lo, hi);
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i alpha_avx2(__m256i x)
+{
+    x = _mm256_srli_epi32(x, 24);
+    x = _mm256_or_si256(x, _mm256_slli_epi32(x, 8));
+    return _mm256_or_si256(x, _mm256_slli_epi32(x, 16));
+}
+
+PLUTOVG_TARGET_AVX2 static inline __m256i inverse_alpha_avx2(__m256i x)
+{
+    return alpha_avx2(_mm256_xor_si256(x, _mm256_set1_epi32(-1)));
+}
+
+PLUTOVG_TARGET_AVX2 static void solid_blend_avx2(uint32_t* dest, int length, uint32_t color, uint32_t ialpha)
+{
+    const __m256i vcolor = _mm256_set1_epi32((int)color);
+    const __m256i via = _mm256_set1_epi32((int)(ialpha * 0x01010101));
+    int i = 0;
+    for(;i + 8 <= length;i += 8)
+    {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        _mm256_storeu_si256((__m256i*)(dest + i), _mm256_add_epi32(vcolor, byte_mul_avx2(d, via)));
+    }
+
+    _mm256_zeroupper();
+    solid_blend_sse2(dest + i, length - i, color, ialpha);
+}
+
+PLUTOVG_TARGET_AVX2 static void solid_mul_avx2(uint32_t* dest, int length, uint32_t a)
+{
+    const __m256i va = _mm256_set1_epi32((int)(a * 0x01010101));
+    int i = 0;
+    for(;i + 8 <= length;i += 8)
+    {
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        _mm256_storeu_si256((__m256i*)(dest + i), byte_mul_avx2(d, va));
+    }
+
+    _mm256_zeroupper();
+    solid_mul_sse2(dest + i, length - i, a);
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_solid_source_avx2(uint32_t* dest, int length, uint32_t color, uint32_t alpha)
+{
+    if(alpha == 255)
+        memfill32(dest, color, length);
+    else
+        solid_blend_avx2(dest, length, BYTE_MUL(color, alpha), 255 - alpha);
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_solid_source_over_avx2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha != 255) color = BYTE_MUL(color, const_alpha);
+    solid_blend_avx2(dest, length, color, 255 - plutovg_alpha(color));
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_solid_destination_in_avx2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    uint32_t a = plutovg_alpha(color);
+    if(const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    solid_mul_avx2(dest, length, a);
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_solid_destination_out_avx2(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    uint32_t a = plutovg_alpha(~color);
+    if(const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    solid_mul_avx2(dest, length, a);
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_source_avx2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    if(const_alpha == 255)
+    {
+        memcpy(dest, src, (size_t)(length) * sizeof(uint32_t));
+        return;
+    }
+
+    const __m256i vca = _mm256_set1_epi32((int)(const_alpha * 0x01010101));
+    const __m256i via = _mm256_set1_epi32((int)((255 - const_alpha) * 0x01010101));
+    int i = 0;
+    for(;i + 8 <= length;i += 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        _mm256_storeu_si256((__m256i*)(dest + i), interpolate_pixel_avx2(s, vca, d, via));
+    }
+
+    _mm256_zeroupper();
+    composition_source_sse2(dest + i, length - i, src + i, const_alpha);
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_source_over_avx2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    int i = 0;
+    if(const_alpha == 255)
+    {
+        for(;i + 8 <= length;i += 8)
+        {
+            __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+            if(_mm256_testz_si256(s, s))
+                continue;
+            __m256i sia = inverse_alpha_avx2(s);
+            if(_mm256_testz_si256(sia, sia))
+            {
+                _mm256_storeu_si256((__m256i*)(dest + i), s);
+                continue;
+            }
+
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+            _mm256_storeu_si256((__m256i*)(dest + i), _mm256_add_epi32(s, byte_mul_avx2(d, sia)));
+        }
+    }
+    else
+    {
+        const __m256i vca = _mm256_set1_epi32((int)(const_alpha * 0x01010101));
+        for(;i + 8 <= length;i += 8)
+        {
+            __m256i s = byte_mul_avx2(_mm256_loadu_si256((const __m256i*)(src + i)), vca);
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+            _mm256_storeu_si256((__m256i*)(dest + i), _mm256_add_epi32(s, byte_mul_avx2(d, inverse_alpha_avx2(s))));
+        }
+    }
+
+    _mm256_zeroupper();
+    composition_source_over_sse2(dest + i, length - i, src + i, const_alpha);
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_destination_in_avx2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    const __m256i vca = _mm256_set1_epi32((int)(const_alpha * 0x01010101));
+    const __m256i vcia = _mm256_set1_epi32((int)((255 - const_alpha) * 0x01010101));
+    int i = 0;
+    for(;i + 8 <= length;i += 8)
+    {
+        __m256i a = alpha_avx2(_mm256_loadu_si256((const __m256i*)(src + i)));
+        if(const_alpha != 255) a = _mm256_add_epi8(byte_mul_avx2(a, vca), vcia);
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        _mm256_storeu_si256((__m256i*)(dest + i), byte_mul_avx2(d, a));
+    }
+
+    _mm256_zeroupper();
+    composition_destination_in_sse2(dest + i, length - i, src + i, const_alpha);
+}
+
+PLUTOVG_TARGET_AVX2 static void composition_destination_out_avx2(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    const __m256i vca = _mm256_set1_epi32((int)(const_alpha * 0x01010101));
+    const __m256i vcia = _mm256_set1_epi32((int)((255 - const_alpha) * 0x01010101));
+    int i = 0;
+    for(;i + 8 <= length;i += 8)
+    {
+        __m256i sia = inverse_alpha_avx2(_mm256_loadu_si256((const __m256i*)(src + i)));
+        if(const_alpha != 255) sia = _mm256_add_epi8(byte_mul_avx2(sia, vca), vcia);
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dest + i));
+        _mm256_storeu_si256((__m256i*)(dest + i), byte_mul_avx2(d, sia));
+    }
+
+    _mm256_zeroupper();
+    composition_destination_out_sse2(dest + i, length - i, src + i, const_alpha);
+}
+#endif
+
+#ifdef PLUTOVG_NEON
+static inline uint32x4_t byte_mul_neon(uint32x4_t x, uint32x4_t a)
+{
+    uint8x16_t x8 = vreinterpretq_u8_u32(x);
+    uint8x16_t a8 = vreinterpretq_u8_u32(a);
+    uint16x8_t lo = vmull_u8(vget_low_u8(x8), vget_low_u8(a8));
+    uint16x8_t hi = vmull_u8(vget_high_u8(x8), vget_high_u8(a8));
+    return vreinterpretq_u32_u8(vcombine_u8(vraddhn_u16(lo, vshrq_n_u16(lo, 8)), vraddhn_u16(hi, vshrq_n_u16(hi, 8))));
+}
+
+static inline uint32x4_t interpolate_pixel_neon(uint32x4_t x, uint32x4_t a, uint32x4_t y, uint32x4_t b)
+{
+    uint8x16_t x8 = vreinterpretq_u8_u32(x);
+    uint8x16_t a8 = vreinterpretq_u8_u32(a);
+    uint8x16_t y8 = vreinterpretq_u8_u32(y);
+    uint8x16_t b8 = vreinterpretq_u8_u32(b);
+    uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(x8), vget_low_u8(a8)), vget_low_u8(y8), vget_low_u8(b8));
+    uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(x8), vget_high_u8(a8)), vget_high_u8(y8), vget_high_u8(b8));
+    return vreinterpretq_u32_u8(vcombine_u8(vraddhn_u16(lo, vshrq_n_u16(lo, 8)), vraddhn_u16(hi, vshrq_n_u16(hi, 8))));
+}
+
+static inline uint32x4_t alpha_neon(uint32x4_t x)
+{
+    return vmulq_n_u32(vshrq_n_u32(x, 24), 0x01010101);
+}
+
+static inline int all_zero_neon(uint32x4_t x)
+{
+    uint32x2_t r = vorr_u32(vget_low_u32(x), vget_high_u32(x));
+    return (vget_lane_u32(r, 0) | vget_lane_u32(r, 1)) == 0;
+}
+
+static void solid_blend_neon(uint32_t* dest, int length, uint32_t color, uint32_t ialpha)
+{
+    const uint32x4_t vcolor = vdupq_n_u32(color);
+    const uint32x4_t via = vdupq_n_u32(ialpha * 0x01010101);
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+        vst1q_u32(dest + i, vaddq_u32(vcolor, byte_mul_neon(vld1q_u32(dest + i), via)));
+    for(;i < length;i++)
+        dest[i] = color + BYTE_MUL(dest[i], ialpha);
+}
+
+static void solid_mul_neon(uint32_t* dest, int length, uint32_t a)
+{
+    const uint32x4_t va = vdupq_n_u32(a * 0x01010101);
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+        vst1q_u32(dest + i, byte_mul_neon(vld1q_u32(dest + i), va));
+    for(;i < length;i++)
+        dest[i] = BYTE_MUL(dest[i], a);
+}
+
+static void composition_solid_source_neon(uint32_t* dest, int length, uint32_t color, uint32_t alpha)
+{
+    if(alpha == 255)
+        memfill32(dest, color, length);
+    else
+        solid_blend_neon(dest, length, BYTE_MUL(color, alpha), 255 - alpha);
+}
+
+static void composition_solid_source_over_neon(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    if(const_alpha != 255) color = BYTE_MUL(color, const_alpha);
+    solid_blend_neon(dest, length, color, 255 - plutovg_alpha(color));
+}
+
+static void composition_solid_destination_in_neon(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    uint32_t a = plutovg_alpha(color);
+    if(const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    solid_mul_neon(dest, length, a);
+}
+
+static void composition_solid_destination_out_neon(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha)
+{
+    uint32_t a = plutovg_alpha(~color);
+    if(const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    solid_mul_neon(dest, length, a);
+}
+
+static void composition_source_neon(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    if(const_alpha == 255)
+    {
+        memcpy(dest, src, (size_t)(length) * sizeof(uint32_t));
+        return;
+    }
+
+    const uint32x4_t vca = vdupq_n_u32(const_alpha * 0x01010101);
+    const uint32x4_t via = vdupq_n_u32((255 - const_alpha) * 0x01010101);
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+        vst1q_u32(dest + i, interpolate_pixel_neon(vld1q_u32(src + i), vca, vld1q_u32(dest + i), via));
+    composition_source(dest + i, length - i, src + i, const_alpha);
+}
+
+static void composition_source_over_neon(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    int i = 0;
+    if(const_alpha == 255)
+    {
+        for(;i + 4 <= length;i += 4)
+        {
+            uint32x4_t s = vld1q_u32(src + i);
+            if(all_zero_neon(s))
+                continue;
+            uint32x4_t sia = alpha_neon(vmvnq_u32(s));
+            if(all_zero_neon(sia))
+            {
+                vst1q_u32(dest + i, s);
+                continue;
+            }
+
+            vst1q_u32(dest + i, vaddq_u32(s, byte_mul_neon(vld1q_u32(dest + i), sia)));
+        }
+    }
+    else
+    {
+        const uint32x4_t vca = vdupq_n_u32(const_alpha * 0x01010101);
+        for(;i + 4 <= length;i += 4)
+        {
+            uint32x4_t s = byte_mul_neon(vld1q_u32(src + i), vca);
+            vst1q_u32(dest + i, vaddq_u32(s, byte_mul_neon(vld1q_u32(dest + i), alpha_neon(vmvnq_u32(s)))));
+        }
+    }
+
+    composition_source_over(dest + i, length - i, src + i, const_alpha);
+}
+
+static void composition_destination_in_neon(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    const uint32x4_t vca = vdupq_n_u32(const_alpha * 0x01010101);
+    const uint32x4_t vcia = vdupq_n_u32((255 - const_alpha) * 0x01010101);
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+    {
+        uint32x4_t a = alpha_neon(vld1q_u32(src + i));
+        if(const_alpha != 255) a = vaddq_u32(byte_mul_neon(a, vca), vcia);
+        vst1q_u32(dest + i, byte_mul_neon(vld1q_u32(dest + i), a));
+    }
+
+    composition_destination_in(dest + i, length - i, src + i, const_alpha);
+}
+
+static void composition_destination_out_neon(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha)
+{
+    const uint32x4_t vca = vdupq_n_u32(const_alpha * 0x01010101);
+    const uint32x4_t vcia = vdupq_n_u32((255 - const_alpha) * 0x01010101);
+    int i = 0;
+    for(;i + 4 <= length;i += 4)
+    {
+        uint32x4_t sia = alpha_neon(vmvnq_u32(vld1q_u32(src + i)));
+        if(const_alpha != 255) sia = vaddq_u32(byte_mul_neon(sia, vca), vcia);
+        vst1q_u32(dest + i, byte_mul_neon(vld1q_u32(dest + i), sia));
+    }
+
+    composition_destination_out(dest + i, length - i, src + i, const_alpha);
+}
+#endif
+
 typedef void(*composition_solid_function_t)(uint32_t* dest, int length, uint32_t color, uint32_t const_alpha);
 typedef void(*composition_function_t)(uint32_t* dest, int length, const uint32_t* src, uint32_t const_alpha);
 
@@ -405,52 +1224,291 @@ static const composition_function_t composition_map[] = {
     composition_destination_out
 };
 
-static void blend_solid(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, uint32_t solid)
+#ifdef PLUTOVG_SSE2
+static const composition_solid_function_t composition_solid_map_sse2[] = {
+    composition_solid_source_sse2,
+    composition_solid_source_over_sse2,
+    composition_solid_destination_in_sse2,
+    composition_solid_destination_out_sse2
+};
+
+static const composition_function_t composition_map_sse2[] = {
+    composition_source_sse2,
+    composition_source_over_sse2,
+    composition_destination_in_sse2,
+    composition_destination_out_sse2
+};
+#endif
+
+#ifdef PLUTOVG_AVX2
+static const composition_solid_function_t composition_solid_map_avx2[] = {
+    composition_solid_source_avx2,
+    composition_solid_source_over_avx2,
+    composition_solid_destination_in_avx2,
+    composition_solid_destination_out_avx2
+};
+
+static const composition_function_t composition_map_avx2[] = {
+    composition_source_avx2,
+    composition_source_over_avx2,
+    composition_destination_in_avx2,
+    composition_destination_out_avx2
+};
+#endif
+
+#ifdef PLUTOVG_NEON
+static const composition_solid_function_t composition_solid_map_neon[] = {
+    composition_solid_source_neon,
+    composition_solid_source_over_neon,
+    composition_solid_destination_in_neon,
+    composition_solid_destination_out_neon
+};
+
+static const composition_function_t composition_map_neon[] = {
+    composition_source_neon,
+    composition_source_over_neon,
+    composition_destination_in_neon,
+    composition_destination_out_neon
+};
+#endif
+
+/*
+ * The widest kernels the CPU runs are picked once per blend call. SSE2 and
+ * NEON are part of the targets they are compiled for; AVX2 is checked with
+ * CPUID, which the compiler runtime caches at startup.
+ */
+static const composition_solid_function_t* composition_solid_table(void)
+{
+#ifdef PLUTOVG_AVX2
+    if(cpu_supports_avx2())
+        return composition_solid_map_avx2;
+#endif
+#if defined(PLUTOVG_SSE2)
+    return composition_solid_map_sse2;
+#elif defined(PLUTOVG_NEON)
+    return composition_solid_map_neon;
+#endif
+    return composition_solid_map;
+}
+
+static const composition_function_t* composition_table(void)
+{
+#ifdef PLUTOVG_AVX2
+    if(cpu_supports_avx2())
+        return composition_map_avx2;
+#endif
+#if defined(PLUTOVG_SSE2)
+    return composition_map_sse2;
+#elif defined(PLUTOVG_NEON)
+    return composition_map_neon;
+#endif
+    return composition_map;
+}
+
+/*
+ * Antialiased edges and small shapes produce many spans only a few pixels
+ * long, on which fetching into a buffer and calling a composition function
+ * costs more than the pixels themselves. Spans shorter than
+ * SHORT_SPAN_LENGTH are fetched, weighted by coverage and composited in a
+ * single loop instead: BLEND_OPERATOR instantiates each blend function once
+ * per operator and COMPOSITE_SPAN once for full and once for partial
+ * coverage, so every such loop is compiled with a single operator and no
+ * indirect calls. Longer spans keep the buffer and the SIMD composition
+ * functions, which outrun any per-pixel loop. composite_pixel and
+ * composite_solid_pixel round exactly like the composition functions.
+ */
+#if defined(_MSC_VER)
+#define PLUTOVG_ALWAYS_INLINE __forceinline
+#elif defined(__GNUC__)
+#define PLUTOVG_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define PLUTOVG_ALWAYS_INLINE inline
+#endif
+
+#define SHORT_SPAN_LENGTH 8
+
+static PLUTOVG_ALWAYS_INLINE uint32_t composite_solid_pixel(plutovg_operator_t op, uint32_t color, uint32_t dest, uint32_t const_alpha)
 {
-    composition_solid_function_t func = composition_solid_map[op];
+    uint32_t a;
+    switch(op)
+    {
+    case plutovg_operator_src:
+        if(const_alpha == 255)
+            return color;
+        return BYTE_MUL(color, const_alpha) + BYTE_MUL(dest, 255 - const_alpha);
+    case plutovg_operator_src_over:
+        if(const_alpha != 255) color = BYTE_MUL(color, const_alpha);
+        return color + BYTE_MUL(dest, 255 - plutovg_alpha(color));
+    case plutovg_operator_dst_in:
+        a = plutovg_alpha(color);
+        break;
+    default:
+        a = plutovg_alpha(~color);
+        break;
+    }
+
+    if(const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    return BYTE_MUL(dest, a);
+}
+
+static PLUTOVG_ALWAYS_INLINE uint32_t composite_pixel(plutovg_operator_t op, uint32_t src, uint32_t dest, uint32_t const_alpha)
+{
+    uint32_t a;
+    switch(op)
+    {
+    case plutovg_operator_src:
+        if(const_alpha == 255)
+            return src;
+        return interpolate_pixel(src, const_alpha, dest, 255 - const_alpha);
+    case plutovg_operator_src_over:
+        if(const_alpha != 255) src = BYTE_MUL(src, const_alpha);
+        return src + BYTE_MUL(dest, plutovg_alpha(~src));
+    case plutovg_operator_dst_in:
+        a = plutovg_alpha(src);
+        break;
+    default:
+        a = plutovg_alpha(~src);
+        break;
+    }
+
+    if(const_alpha != 255) a = BYTE_MUL(a, const_alpha) + 255 - const_alpha;
+    return BYTE_MUL(dest, a);
+}
+
+#define COMPOSITE_SPAN(composite, op, dest, length, const_alpha, pixel, advance) \
+    do { \
+        if((const_alpha) == 255) { \
+            for(int i = 0;i < (length);i++) { \
+                (dest)[i] = composite(op, pixel, (dest)[i], 255); \
+                advance; \
+            } \
+        } else { \
+            for(int i = 0;i < (length);i++) { \
+                (dest)[i] = composite(op, pixel, (dest)[i], const_alpha); \
+                advance; \
+            } \
+        } \
+    } while(0)
+
+#define BLEND_OPERATOR(blend, op, ...) \
+    do { \
+        switch(op) { \
+        case plutovg_operator_src: blend(plutovg_operator_src, __VA_ARGS__); break; \
+        case plutovg_operator_src_over: blend(plutovg_operator_src_over, __VA_ARGS__); break; \
+        case plutovg_operator_dst_in: blend(plutovg_operator_dst_in, __VA_ARGS__); break; \
+        case plutovg_operator_dst_out: blend(plutovg_operator_dst_out, __VA_ARGS__); break; \
+        } \
+    } while(0)
+
+static PLUTOVG_ALWAYS_INLINE void blend_solid_op(plutovg_operator_t op, plutovg_surface_t* surface, const plutovg_rle_t* rle, uint32_t solid)
+{
+    composition_solid_function_t func = composition_solid_table()[op];
     int count = rle->spans.size;
     const plutovg_span_t* spans = rle->spans.data;
     while(count--)
     {
         uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
-        func(target, spans->len, solid, spans->coverage);
+        if(spans->len < SHORT_SPAN_LENGTH)
+            COMPOSITE_SPAN(composite_solid_pixel, op, target, spans->len, spans->coverage, solid, (void)0);
+        else
+            func(target, spans->len, solid, spans->coverage);
         ++spans;
     }
 }
 
+static void blend_solid(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, uint32_t solid)
+{
+    BLEND_OPERATOR(blend_solid_op, op, surface, rle, solid);
+}
+
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define BUFFER_SIZE 1024
-static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const gradient_data_t* gradient)
+static PLUTOVG_ALWAYS_INLINE void blend_linear_gradient_op(plutovg_operator_t op, plutovg_surface_t* surface, const plutovg_rle_t* rle, const gradient_data_t* gradient, const linear_gradient_values_t* v)
 {
-    composition_function_t func = composition_map[op];
+    composition_function_t func = composition_table()[op];
     unsigned int buffer[BUFFER_SIZE];
 
+    int count = rle->spans.size;
+    const plutovg_span_t* spans = rle->spans.data;
+    while(count--)
+    {
+        int length = spans->len;
+        int x = spans->x;
+        uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
+        double t = linear_gradient_position(v, gradient, spans->y, x);
+        if(length < SHORT_SPAN_LENGTH && linear_gradient_fixed(v, t, length))
+        {
+            int t_fixed = (int)(t * FIXPT_SIZE);
+            int inc_fixed = (int)(v->inc * FIXPT_SIZE);
+            COMPOSITE_SPAN(composite_pixel, op, target, length, spans->coverage, gradient_pixel_fixed(gradient, t_fixed), t_fixed += inc_fixed);
+        }
+        else
+        {
+            while(length)
+            {
+                int l = MIN(length, BUFFER_SIZE);
+                fetch_linear_gradient(buffer, v, gradient, t, l);
+                func(target, l, buffer, spans->coverage);
+                target += l;
+                x += l;
+                length -= l;
+                t = linear_gradient_position(v, gradient, spans->y, x);
+            }
+        }
+
+        ++spans;
+    }
+}
+
+static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const gradient_data_t* gradient)
+{
     linear_gradient_values_t v;
     v.dx = gradient->linear.x2 - gradient->linear.x1;
     v.dy = gradient->linear.y2 - gradient->linear.y1;
     v.l = v.dx * v.dx + v.dy * v.dy;
     v.off = 0.0;
+    v.inc = 0.0;
     if(v.l != 0.0)
     {
         v.dx /= v.l;
         v.dy /= v.l;
         v.off = -v.dx * gradient->linear.x1 - v.dy * gradient->linear.y1;
+        v.inc = v.dx * gradient->matrix.m00 + v.dy * gradient->matrix.m10;
+        v.inc *= (COLOR_TABLE_SIZE - 1);
     }
 
+    BLEND_OPERATOR(blend_linear_gradient_op, op, surface, rle, gradient, &v);
+}
+
+static PLUTOVG_ALWAYS_INLINE void blend_radial_gradient_op(plutovg_operator_t op, plutovg_surface_t* surface, const plutovg_rle_t* rle, const gradient_data_t* gradient, const radial_gradient_values_t* v)
+{
+    composition_function_t func = composition_table()[op];
+    unsigned int buffer[BUFFER_SIZE];
+
     int count = rle->spans.size;
     const plutovg_span_t* spans = rle->spans.data;
     while(count--)
     {
         int length = spans->len;
         int x = spans->x;
-        while(length)
+        uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
+        if(length < SHORT_SPAN_LENGTH && v->a != 0.0)
         {
-            int l = MIN(length, BUFFER_SIZE);
-            fetch_linear_gradient(buffer, &v, gradient, spans->y, x, l);
-            uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
-            func(target, l, buffer, spans->coverage);
-            x += l;
-            length -= l;
+            radial_gradient_step_t step;
+            radial_gradient_start(&step, v, gradient, spans->y, x);
+            COMPOSITE_SPAN(composite_pixel, op, target, length, spans->coverage, radial_gradient_pixel(v, gradient, &step), radial_gradient_advance(&step));
+        }
+        else
+        {
+            while(length)
+            {
+                int l = MIN(length, BUFFER_SIZE);
+                fetch_radial_gradient(buffer, v, gradient, spans->y, x, l);
+                func(target, l, buffer, spans->coverage);
+                target += l;
+                x += l;
+                length -= l;
+            }
         }
 
         ++spans;
@@ -459,9 +1517,6 @@ static void blend_linear_gradient(plutovg_surface_t* surface, plutovg_operator_t
 
 static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const gradient_data_t* gradient)
 {
-    composition_function_t func = composition_map[op];
-    unsigned int buffer[BUFFER_SIZE];
-
     radial_gradient_values_t v;
     v.dx = gradient->radial.cx - gradient->radial.fx;
     v.dy = gradient->radial.cy - gradient->radial.fy;
@@ -471,35 +1526,33 @@ static void blend_radial_gradient(plutovg_surface_t* surface, plutovg_operator_t
     v.inv2a = 1.0 / (2.0 * v.a);
     v.extended = gradient->radial.fr != 0.0 || v.a <= 0.0;
 
-    int count = rle->spans.size;
-    const plutovg_span_t* spans = rle->spans.data;
-    while(count--)
-    {
-        int length = spans->len;
-        int x = spans->x;
-        while(length)
-        {
-            int l = MIN(length, BUFFER_SIZE);
-            fetch_radial_gradient(buffer, &v, gradient, spans->y, x, l);
-            uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
-            func(target, l, buffer, spans->coverage);
-            x += l;
-            length -= l;
-        }
+    v.inv_a2 = v.inv2a * v.inv2a;
+    v.delta_b = 2 * (gradient->matrix.m00 * v.dx + gradient->matrix.m10 * v.dy);
+    v.delta_bb = v.delta_b * v.delta_b;
+    v.delta_rxrxryry = gradient->matrix.m00 * gradient->matrix.m00 + gradient->matrix.m10 * gradient->matrix.m10;
+    v.delta_delta_det = (2 * v.delta_b * v.delta_b + 4 * v.a * (2 * v.delta_rxrxryry)) * v.inv_a2;
 
-        ++spans;
-    }
+    BLEND_OPERATOR(blend_radial_gradient_op, op, surface, rle, gradient, &v);
 }
 
 #define CLAMP(v, lo, hi) ((v) < (lo) ? (lo) : (hi) < (v) ? (hi) : (v))
 #define FIXED_SCALE (1 << 16)
-static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const texture_data_t* texture)
+static inline uint32_t transformed_pixel(const uint8_t* image_bits, int stride, int image_width, int image_height, int x, int y)
+{
+    int px = CLAMP(x >> 16, 0, image_width - 1);
+    int py = CLAMP(y >> 16, 0, image_height - 1);
+    return ((const uint32_t*)(image_bits + py * stride))[px];
+}
+
+static PLUTOVG_ALWAYS_INLINE void blend_transformed_argb_op(plutovg_operator_t op, plutovg_surface_t* surface, const plutovg_rle_t* rle, const texture_data_t* texture)
 {
-    composition_function_t func = composition_map[op];
+    composition_function_t func = composition_table()[op];
     uint32_t buffer[BUFFER_SIZE];
 
+    const uint8_t* image_bits = texture->data;
     int image_width = texture->width;
     int image_height = texture->height;
+    int stride = texture->stride;
 
     int fdx = (int)(texture->matrix.m00 * FIXED_SCALE);
     int fdy = (int)(texture->matrix.m10 * FIXED_SCALE);
@@ -518,6 +1571,12 @@ static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_
 
         int length = spans->len;
         const int coverage = (spans->coverage * texture->const_alpha) >> 8;
+        if(length < SHORT_SPAN_LENGTH)
+        {
+            COMPOSITE_SPAN(composite_pixel, op, target, length, coverage, transformed_pixel(image_bits, stride, image_width, image_height, x, y), (x += fdx, y += fdy));
+            length = 0;
+        }
+
         while(length)
         {
             int l = MIN(length, BUFFER_SIZE);
@@ -525,10 +1584,7 @@ static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_
             uint32_t* b = buffer;
             while(b < end)
             {
-                int px = CLAMP(x >> 16, 0, image_width - 1);
-                int py = CLAMP(y >> 16, 0, image_height - 1);
-                *b = ((const uint32_t*)(texture->data + py * texture->stride))[px];
-
+                *b = transformed_pixel(image_bits, stride, image_width, image_height, x, y);
                 x += fdx;
                 y += fdy;
                 ++b;
@@ -543,9 +1599,14 @@ static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_
     }
 }
 
-static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const texture_data_t* texture)
+static void blend_transformed_argb(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const texture_data_t* texture)
+{
+    BLEND_OPERATOR(blend_transformed_argb_op, op, surface, rle, texture);
+}
+
+static PLUTOVG_ALWAYS_INLINE void blend_untransformed_argb_op(plutovg_operator_t op, plutovg_surface_t* surface, const plutovg_rle_t* rle, const texture_data_t* texture)
 {
-    composition_function_t func = composition_map[op];
+    composition_function_t func = composition_table()[op];
 
     const int image_width = texture->width;
     const int image_height = texture->height;
@@ -575,7 +1636,10 @@ static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operato
                 const int coverage = (spans->coverage * texture->const_alpha) >> 8;
                 const uint32_t* src = (const uint32_t*)(texture->data + sy * texture->stride) + sx;
                 uint32_t* dest = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
-                func(dest, length, src, coverage);
+                if(length < SHORT_SPAN_LENGTH)
+                    COMPOSITE_SPAN(composite_pixel, op, dest, length, coverage, src[i], (void)0);
+                else
+                    func(dest, length, src, coverage);
             }
         }
 
@@ -583,9 +1647,14 @@ static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operato
     }
 }
 
-static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const texture_data_t* texture)
+static void blend_untransformed_argb(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const texture_data_t* texture)
+{
+    BLEND_OPERATOR(blend_untransformed_argb_op, op, surface, rle, texture);
+}
+
+static PLUTOVG_ALWAYS_INLINE void blend_untransformed_tiled_argb_op(plutovg_operator_t op, plutovg_surface_t* surface, const plutovg_rle_t* rle, const texture_data_t* texture)
 {
-    composition_function_t func = composition_map[op];
+    composition_function_t func = composition_table()[op];
 
     int image_width = texture->width;
     int image_height = texture->height;
@@ -619,7 +1688,10 @@ static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_o
                 l = BUFFER_SIZE;
             const uint32_t* src = (const uint32_t*)(texture->data + sy * texture->stride) + sx;
             uint32_t* dest = (uint32_t*)(surface->data + spans->y * surface->stride) + x;
-            func(dest, l, src, coverage);
+            if(l < SHORT_SPAN_LENGTH)
+                COMPOSITE_SPAN(composite_pixel, op, dest, l, coverage, src[i], (void)0);
+            else
+                func(dest, l, src, coverage);
             x += l;
             length -= l;
             sx = 0;
@@ -629,24 +1701,50 @@ static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_o
     }
 }
 
-static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const texture_data_t* texture)
+static void blend_untransformed_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const texture_data_t* texture)
+{
+    BLEND_OPERATOR(blend_untransformed_tiled_argb_op, op, surface, rle, texture);
+}
+
+static inline uint32_t transformed_tiled_pixel(const uint32_t* image_bits, int scanline_offset, int image_width, int image_height, int* px16, int* py16)
+{
+    if(*px16 < 0) *px16 += image_width << 16;
+    if(*py16 < 0) *py16 += image_height << 16;
+    int px = *px16 >> 16;
+    int py = *py16 >> 16;
+    return image_bits[py * scanline_offset + px];
+}
+
+static inline void transformed_tiled_advance(int image_width, int image_height, int* px16, int* py16, int px_delta, int py_delta)
+{
+    *px16 += px_delta;
+    if(*px16 >= image_width << 16)
+        *px16 -= image_width << 16;
+    *py16 += py_delta;
+    if(*py16 >= image_height << 16)
+        *py16 -= image_height << 16;
+}
+
+static PLUTOVG_ALWAYS_INLINE void blend_transformed_tiled_argb_op(plutovg_operator_t op, plutovg_surface_t* surface, const plutovg_rle_t* rle, const texture_data_t* texture)
 {
-    composition_function_t func = composition_map[op];
+    composition_function_t func = composition_table()[op];
     uint32_t buffer[BUFFER_SIZE];
 
+    const uint32_t* image_bits = (const uint32_t*)texture->data;
     int image_width = texture->width;
     int image_height = texture->height;
     const int scanline_offset = texture->stride / 4;
 
     int fdx = (int)(texture->matrix.m00 * FIXED_SCALE);
     int fdy = (int)(texture->matrix.m10 * FIXED_SCALE);
+    int px_delta = fdx % (image_width << 16);
+    int py_delta = fdy % (image_height << 16);
 
     int count = rle->spans.size;
     const plutovg_span_t* spans = rle->spans.data;
     while(count--)
     {
         uint32_t* target = (uint32_t*)(surface->data + spans->y * surface->stride) + spans->x;
-        const uint32_t* image_bits = (const uint32_t*)texture->data;
 
         const double cx = spans->x + 0.5;
         const double cy = spans->y + 0.5;
@@ -659,33 +1757,28 @@ static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_ope
         while(length)
         {
             int l = MIN(length, BUFFER_SIZE);
-            const uint32_t* end = buffer + l;
-            uint32_t* b = buffer;
             int px16 = x % (image_width << 16);
             int py16 = y % (image_height << 16);
-            int px_delta = fdx % (image_width << 16);
-            int py_delta = fdy % (image_height << 16);
-            while(b < end)
+            if(l < SHORT_SPAN_LENGTH)
             {
-                if(px16 < 0) px16 += image_width << 16;
-                if(py16 < 0) py16 += image_height << 16;
-                int px = px16 >> 16;
-                int py = py16 >> 16;
-                int y_offset = py * scanline_offset;
-
-                *b = image_bits[y_offset + px];
-                x += fdx;
-                y += fdy;
-                px16 += px_delta;
-                if(px16 >= image_width << 16)
-                    px16 -= image_width << 16;
-                py16 += py_delta;
-                if(py16 >= image_height << 16)
-                    py16 -= image_height << 16;
-                ++b;
+                COMPOSITE_SPAN(composite_pixel, op, target, l, coverage, transformed_tiled_pixel(image_bits, scanline_offset, image_width, image_height, &px16, &py16), transformed_tiled_advance(image_width, image_height, &px16, &py16, px_delta, py_delta));
+            }
+            else
+            {
+                const uint32_t* end = buffer + l;
+                uint32_t* b = buffer;
+                while(b < end)
+                {
+                    *b = transformed_tiled_pixel(image_bits, scanline_offset, image_width, image_height, &px16, &py16);
+                    transformed_tiled_advance(image_width, image_height, &px16, &py16, px_delta, py_delta);
+                    ++b;
+                }
+
+                func(target, l, buffer, coverage);
             }
 
-            func(target, l, buffer, coverage);
+            x += fdx * l;
+            y += fdy * l;
             target += l;
             length -= l;
         }
@@ -694,6 +1787,11 @@ static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_ope
     }
 }
 
+static void blend_transformed_tiled_argb(plutovg_surface_t* surface, plutovg_operator_t op, const plutovg_rle_t* rle, const texture_data_t* texture)
+{
+    BLEND_OPERATOR(blend_transformed_tiled_argb_op, op, surface, rle, texture);
+}
+
 void plutovg_blend(plutovg_t* pluto, const plutovg_rle_t* rle)
 {
     plutovg_paint_t* source = pluto->state->source;
@@ -1,413 +1,615 @@
-#include "plutovg-private.h"
-
-#include "sw_ft_raster.h"
-#include "sw_ft_stroker.h"
-#include "sw_ft_types.h"
-#include "sw_ft_math.h"
-
-#include <math.h>
-#include <limits.h>
-
-static SW_FT_Outline* sw_ft_outline_create(int points, int contours)
-{
-    SW_FT_Outline* ft = malloc(sizeof(SW_FT_Outline));
-    ft->points = malloc((size_t)(points + contours) * sizeof(SW_FT_Vector));
-    ft->tags = malloc((size_t)(points + contours) * sizeof(char));
-    ft->contours = malloc((size_t)contours * sizeof(short));
-    ft->contours_flag = malloc((size_t)contours * sizeof(char));
-    ft->n_points = ft->n_contours = 0;
-    ft->flags = 0x0;
-    return ft;
-}
-
-static void sw_ft_outline_destroy(SW_FT_Outline* ft)
-{
-    free(ft->points);
-    free(ft->tags);
-    free(ft->contours);
-    free(ft->contours_flag);
-    free(ft);
-}
-
-#define FT_COORD(x) (SW_FT_Pos)((x) * 64)
-static void sw_ft_outline_move_to(SW_FT_Outline* ft, double x, double y)
-{
-    ft->points[ft->n_points].x = FT_COORD(x);
-    ft->points[ft->n_points].y = FT_COORD(y);
-    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_ON;
-    if(ft->n_points)
-    {
-        ft->contours[ft->n_contours] = ft->n_points - 1;
-        ft->n_contours++;
-    }
-
-    ft->contours_flag[ft->n_contours] = 1;
-    ft->n_points++;
-}
-
-static void sw_ft_outline_line_to(SW_FT_Outline* ft, double x, double y)
-{
-    ft->points[ft->n_points].x = FT_COORD(x);
-    ft->points[ft->n_points].y = FT_COORD(y);
-    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_ON;
-    ft->n_points++;
-}
-
-static void sw_ft_outline_cubic_to(SW_FT_Outline* ft, double x1, double y1, double x2, double y2, double x3, double y3)
-{
-    ft->points[ft->n_points].x = FT_COORD(x1);
-    ft->points[ft->n_points].y = FT_COORD(y1);
-    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_CUBIC;
-    ft->n_points++;
-
-    ft->points[ft->n_points].x = FT_COORD(x2);
-    ft->points[ft->n_points].y = FT_COORD(y2);
-    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_CUBIC;
-    ft->n_points++;
-
-    ft->points[ft->n_points].x = FT_COORD(x3);
-    ft->points[ft->n_points].y = FT_COORD(y3);
-    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_ON;
-    ft->n_points++;
-}
-
-static void sw_ft_outline_close(SW_FT_Outline* ft)
-{
-    ft->contours_flag[ft->n_contours] = 0;
-    int index = ft->n_contours ? ft->contours[ft->n_contours - 1] + 1 : 0;
-    if(index == ft->n_points)
-        return;
-
-    ft->points[ft->n_points].x = ft->points[index].x;
-    ft->points[ft->n_points].y = ft->points[index].y;
-    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_ON;
-    ft->n_points++;
-}
-
-static void sw_ft_outline_end(SW_FT_Outline* ft)
-{
-    if(ft->n_points)
-    {
-        ft->contours[ft->n_contours] = ft->n_points - 1;
-        ft->n_contours++;
-    }
-}
-
-static SW_FT_Outline* sw_ft_outline_convert(const plutovg_path_t* path, const plutovg_matrix_t* matrix)
-{
-    SW_FT_Outline* outline = sw_ft_outline_create(path->points.size, path->contours);
-    plutovg_path_element_t* elements = path->elements.data;
-    plutovg_point_t* points = path->points.data;
-    plutovg_point_t p[3];
-    for(int i = 0;i < path->elements.size;i++)
-    {
-        switch(elements[i])
-        {
-        case plutovg_path_element_move_to:
-            plutovg_matrix_map_point(matrix, &points[0], &p[0]);
-            sw_ft_outline_move_to(outline, p[0].x, p[0].y);
-            points += 1;
-            break;
-        case plutovg_path_element_line_to:
-            plutovg_matrix_map_point(matrix, &points[0], &p[0]);
-            sw_ft_outline_line_to(outline, p[0].x, p[0].y);
-            points += 1;
-            break;
-        case plutovg_path_element_cubic_to:
-            plutovg_matrix_map_point(matrix, &points[0], &p[0]);
-            plutovg_matrix_map_point(matrix, &points[1], &p[1]);
-            plutovg_matrix_map_point(matrix, &points[2], &p[2]);
-            sw_ft_outline_cubic_to(outline, p[0].x, p[0].y, p[1].x, p[1].y, p[2].x, p[2].y);
-            points += 3;
-            break;
-        case plutovg_path_element_close:
-            sw_ft_outline_close(outline);
-            points += 1;
-            break;
-        }
-    }
-
-    sw_ft_outline_end(outline);
-    return outline;
-}
-
-static SW_FT_Outline* sw_ft_outline_convert_dash(const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_dash_t* dash)
-{
-    plutovg_path_t* dashed = plutovg_dash_path(dash, path);
-    SW_FT_Outline* outline = sw_ft_outline_convert(dashed, matrix);
-    plutovg_path_destroy(dashed);
-    return outline;
-}
-
-static void generation_callback(int count, const SW_FT_Span* spans, void* user)
-{
-    plutovg_rle_t* rle = user;
-    plutovg_array_ensure(rle->spans, count);
-    plutovg_span_t* data = rle->spans.data + rle->spans.size;
-    memcpy(data, spans, (size_t)count * sizeof(plutovg_span_t));
-    rle->spans.size += count;
-}
-
-static void bbox_callback(int x, int y, int w, int h, void* user)
-{
-    plutovg_rle_t* rle = user;
-    rle->x = x;
-    rle->y = y;
-    rle->w = w;
-    rle->h = h;
-}
-
-plutovg_rle_t* plutovg_rle_create(void)
-{
-    plutovg_rle_t* rle = malloc(sizeof(plutovg_rle_t));
-    plutovg_array_init(rle->spans);
-    rle->x = 0;
-    rle->y = 0;
-    rle->w = 0;
-    rle->h = 0;
-    return rle;
-}
-
-void plutovg_rle_destroy(plutovg_rle_t* rle)
-{
-    if(rle==NULL)
-        return;
-
-    free(rle->spans.data);
-    free(rle);
-}
-
-#define SQRT2 1.41421356237309504880
-void plutovg_rle_rasterize(plutovg_rle_t* rle, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip, const plutovg_stroke_data_t* stroke, plutovg_fill_rule_t winding)
-{
-    SW_FT_Raster_Params params;
-    params.flags = SW_FT_RASTER_FLAG_DIRECT | SW_FT_RASTER_FLAG_AA;
-    params.gray_spans = generation_callback;
-    params.bbox_cb = bbox_callback;
-    params.user = rle;
-
-    if(clip)
-    {
-        params.flags |= SW_FT_RASTER_FLAG_CLIP;
-        params.clip_box.xMin = (SW_FT_Pos)clip->x;
-        params.clip_box.yMin = (SW_FT_Pos)clip->y;
-        params.clip_box.xMax = (SW_FT_Pos)(clip->x + clip->w);
-        params.clip_box.yMax = (SW_FT_Pos)(clip->y + clip->h);
-    }
-
-    if(stroke)
-    {
-        SW_FT_Outline* outline = stroke->dash ? sw_ft_outline_convert_dash(path, matrix, stroke->dash) : sw_ft_outline_convert(path, matrix);
-        SW_FT_Stroker_LineCap ftCap;
-        SW_FT_Stroker_LineJoin ftJoin;
-        SW_FT_Fixed ftWidth;
-        SW_FT_Fixed ftMiterLimit;
-
-        plutovg_point_t p1 = {0, 0};
-        plutovg_point_t p2 = {SQRT2, SQRT2};
-        plutovg_point_t p3;
-
-        plutovg_matrix_map_point(matrix, &p1, &p1);
-        plutovg_matrix_map_point(matrix, &p2, &p2);
-
-        p3.x = p2.x - p1.x;
-        p3.y = p2.y - p1.y;
-
-        double scale = sqrt(p3.x*p3.x + p3.y*p3.y) / 2.0;
-
-        ftWidth = (SW_FT_Fixed)(stroke->width * scale * 0.5 * (1 << 6));
-        ftMiterLimit = (SW_FT_Fixed)(stroke->miterlimit * (1 << 16));
-
-        switch(stroke->cap)
-        {
-        case plutovg_line_cap_square:
-            ftCap = SW_FT_STROKER_LINECAP_SQUARE;
-            break;
-        case plutovg_line_cap_round:
-            ftCap = SW_FT_STROKER_LINECAP_ROUND;
-            break;
-        default:
-            ftCap = SW_FT_STROKER_LINECAP_BUTT;
-            break;
-        }
-
-        switch(stroke->join)
-        {
-        case plutovg_line_join_bevel:
-            ftJoin = SW_FT_STROKER_LINEJOIN_BEVEL;
-            break;
-        case plutovg_line_join_round:
-            ftJoin = SW_FT_STROKER_LINEJOIN_ROUND;
-            break;
-        default:
-            ftJoin = SW_FT_STROKER_LINEJOIN_MITER_FIXED;
-            break;
-        }
-
-        SW_FT_Stroker stroker;
-        SW_FT_Stroker_New(&stroker);
-        SW_FT_Stroker_Set(stroker, ftWidth, ftCap, ftJoin, ftMiterLimit);
-        SW_FT_Stroker_ParseOutline(stroker, outline);
-
-        SW_FT_UInt points;
-        SW_FT_UInt contours;
-        SW_FT_Stroker_GetCounts(stroker, &points, &contours);
-
-        SW_FT_Outline* strokeOutline = sw_ft_outline_create((int)points, (int)contours);
-        SW_FT_Stroker_Export(stroker, strokeOutline);
-        SW_FT_Stroker_Done(stroker);
-
-        strokeOutline->flags = SW_FT_OUTLINE_NONE;
-        params.source = strokeOutline;
-        sw_ft_grays_raster.raster_render(NULL, &params);
-        sw_ft_outline_destroy(outline);
-        sw_ft_outline_destroy(strokeOutline);
-    }
-    else
-    {
-        SW_FT_Outline* outline = sw_ft_outline_convert(path, matrix);
-        outline->flags = winding == plutovg_fill_rule_even_odd ? SW_FT_OUTLINE_EVEN_ODD_FILL : SW_FT_OUTLINE_NONE;
-        params.source = outline;
-        sw_ft_grays_raster.raster_render(NULL, &params);
-        sw_ft_outline_destroy(outline);
-    }
-}
-
-#define MIN(a, b) ((a) < (b) ? (a) : (b))
-#define MAX(a, b) ((a) > (b) ? (a) : (b))
-#define DIV255(x) (((x) + ((x) >> 8) + 0x80) >> 8)
-plutovg_rle_t* plutovg_rle_intersection(const plutovg_rle_t* a, const plutovg_rle_t* b)
-{
-    int count = MAX(a->spans.size, b->spans.size);
-    plutovg_rle_t* result = malloc(sizeof(plutovg_rle_t));
-    plutovg_array_init(result->spans);
-    plutovg_array_ensure(result->spans, count);
-
-    plutovg_span_t* a_spans = a->spans.data;
-    plutovg_span_t* a_end = a_spans + a->spans.size;
-
-    plutovg_span_t* b_spans = b->spans.data;
-    plutovg_span_t* b_end = b_spans + b->spans.size;
-
-    while(count && a_spans < a_end && b_spans < b_end)
-    {
-        if(b_spans->y > a_spans->y)
-        {
-            ++a_spans;
-            continue;
-        }
-
-        if(a_spans->y != b_spans->y)
-        {
-            ++b_spans;
-            continue;
-        }
-
-        int ax1 = a_spans->x;
-        int ax2 = ax1 + a_spans->len;
-        int bx1 = b_spans->x;
-        int bx2 = bx1 + b_spans->len;
-
-        if(bx1 < ax1 && bx2 < ax1)
-        {
-            ++b_spans;
-            continue;
-        }
-        else if(ax1 < bx1 && ax2 < bx1)
-        {
-            ++a_spans;
-            continue;
-        }
-
-        int x = MAX(ax1, bx1);
-        int len = MIN(ax2, bx2) - x;
-        if(len)
-        {
-            plutovg_span_t* span = result->spans.data + result->spans.size;
-            span->x = (short)x;
-            span->len = (unsigned short)len;
-            span->y = a_spans->y;
-            span->coverage = DIV255(a_spans->coverage * b_spans->coverage);
-            ++result->spans.size;
-            --count;
-        }
-
-        if(ax2 < bx2)
-        {
-            ++a_spans;
-        }
-        else
-        {
-            ++b_spans;
-        }
-    }
-
-    if(result->spans.size==0)
-    {
-        result->x = 0;
-        result->y = 0;
-        result->w = 0;
-        result->h = 0;
-        return result;
-    }
-
-    plutovg_span_t* spans = result->spans.data;
-    int x1 = INT_MAX;
-    int y1 = spans[0].y;
-    int x2 = 0;
-    int y2 = spans[result->spans.size - 1].y;
-    for(int i = 0;i < result->spans.size;i++)
-    {
-        if(spans[i].x < x1) x1 = spans[i].x;
-        if(spans[i].x + spans[i].len > x2) x2 = spans[i].x + spans[i].len;
-    }
-
-    result->x = x1;
-    result->y = y1;
-    result->w = x2 - x1;
-    result->h = y2 - y1 + 1;
-    return result;
-}
-
-void plutovg_rle_clip_path(plutovg_rle_t* rle, const plutovg_rle_t* clip)
-{
-    if(rle==NULL || clip==NULL)
-        return;
-
-    plutovg_rle_t* result = plutovg_rle_intersection(rle, clip);
-    plutovg_array_ensure(rle->spans, result->spans.size);
-    memcpy(rle->spans.data, result->spans.data, (size_t)result->spans.size * sizeof(plutovg_span_t));
-    rle->spans.size = result->spans.size;
-    rle->x = result->x;
-    rle->y = result->y;
-    rle->w = result->w;
-    rle->h = result->h;
-    plutovg_rle_destroy(result);
-}
-
-plutovg_rle_t* plutovg_rle_clone(const plutovg_rle_t* rle)
-{
-    if(rle==NULL)
-        return NULL;
-
-    plutovg_rle_t* result = malloc(sizeof(plutovg_rle_t));
-    plutovg_array_init(result->spans);
-    plutovg_array_ensure(result->spans, rle->spans.size);
-
-    memcpy(result->spans.data, rle->spans.data, (size_t)rle->spans.size * sizeof(plutovg_span_t));
-    result->spans.size = rle->spans.size;
-    result->x = rle->x;
-    result->y = rle->y;
-    result->w = rle->w;
-    result->h = rle->h;
-    return result;
-}
-
-void plutovg_rle_clear(plutovg_rle_t* rle)
-{
-    rle->spans.size = 0;
-    rle->x = 0;
-    rle->y = 0;
-    rle->w = 0;
-    rle->h = 0;
-}
+#include "plutovg-private.h"
+
+#include "sw_ft_raster.h"
+#include "sw_ft_stroker.h"
+#include "sw_ft_types.h"
+#include "sw_ft_math.h"
+
+#include <math.h>
+#include <limits.h>
+
+typedef struct {
+    SW_FT_Outline ft;
+    int points_capacity;
+    int contours_capacity;
+} sw_ft_outline_buffer_t;
+
+static void sw_ft_outline_init(sw_ft_outline_buffer_t* buffer)
+{
+    memset(buffer, 0, sizeof(sw_ft_outline_buffer_t));
+}
+
+static void sw_ft_outline_done(sw_ft_outline_buffer_t* buffer)
+{
+    free(buffer->ft.points);
+    free(buffer->ft.tags);
+    free(buffer->ft.contours);
+    free(buffer->ft.contours_flag);
+}
+
+static int sw_ft_outline_grow(int capacity, int count)
+{
+    int newcapacity = capacity == 0 ? 64 : capacity;
+    while(newcapacity < count) { newcapacity *= 2; }
+    return newcapacity;
+}
+
+static SW_FT_Outline* sw_ft_outline_reset(sw_ft_outline_buffer_t* buffer, int points, int contours)
+{
+    SW_FT_Outline* ft = &buffer->ft;
+    if(points + contours > buffer->points_capacity)
+    {
+        int capacity = sw_ft_outline_grow(buffer->points_capacity, points + contours);
+        ft->points = realloc(ft->points, (size_t)capacity * sizeof(SW_FT_Vector));
+        ft->tags = realloc(ft->tags, (size_t)capacity * sizeof(char));
+        buffer->points_capacity = capacity;
+    }
+
+    if(contours > buffer->contours_capacity)
+    {
+        int capacity = sw_ft_outline_grow(buffer->contours_capacity, contours);
+        ft->contours = realloc(ft->contours, (size_t)capacity * sizeof(short));
+        ft->contours_flag = realloc(ft->contours_flag, (size_t)capacity * sizeof(char));
+        buffer->contours_capacity = capacity;
+    }
+
+    ft->n_points = ft->n_contours = 0;
+    ft->flags = 0x0;
+    return ft;
+}
+
+#define FT_COORD(x) (SW_FT_Pos)floor((x) * 64)
+static void sw_ft_outline_move_to(SW_FT_Outline* ft, double x, double y)
+{
+    ft->points[ft->n_points].x = FT_COORD(x);
+    ft->points[ft->n_points].y = FT_COORD(y);
+    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_ON;
+    if(ft->n_points)
+    {
+        ft->contours[ft->n_contours] = ft->n_points - 1;
+        ft->n_contours++;
+    }
+
+    ft->contours_flag[ft->n_contours] = 1;
+    ft->n_points++;
+}
+
+static void sw_ft_outline_line_to(SW_FT_Outline* ft, double x, double y)
+{
+    ft->points[ft->n_points].x = FT_COORD(x);
+    ft->points[ft->n_points].y = FT_COORD(y);
+    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_ON;
+    ft->n_points++;
+}
+
+static void sw_ft_outline_cubic_to(SW_FT_Outline* ft, double x1, double y1, double x2, double y2, double x3, double y3)
+{
+    ft->points[ft->n_points].x = FT_COORD(x1);
+    ft->points[ft->n_points].y = FT_COORD(y1);
+    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_CUBIC;
+    ft->n_points++;
+
+    ft->points[ft->n_points].x = FT_COORD(x2);
+    ft->points[ft->n_points].y = FT_COORD(y2);
+    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_CUBIC;
+    ft->n_points++;
+
+    ft->points[ft->n_points].x = FT_COORD(x3);
+    ft->points[ft->n_points].y = FT_COORD(y3);
+    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_ON;
+    ft->n_points++;
+}
+
+static void sw_ft_outline_close(SW_FT_Outline* ft)
+{
+    ft->contours_flag[ft->n_contours] = 0;
+    int index = ft->n_contours ? ft->contours[ft->n_contours - 1] + 1 : 0;
+    if(index == ft->n_points)
+        return;
+
+    ft->points[ft->n_points].x = ft->points[index].x;
+    ft->points[ft->n_points].y = ft->points[index].y;
+    ft->tags[ft->n_points] = SW_FT_CURVE_TAG_ON;
+    ft->n_points++;
+}
+
+static void sw_ft_outline_end(SW_FT_Outline* ft)
+{
+    if(ft->n_points)
+    {
+        ft->contours[ft->n_contours] = ft->n_points - 1;
+        ft->n_contours++;
+    }
+}
+
+static SW_FT_Outline* sw_ft_outline_convert(sw_ft_outline_buffer_t* buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix)
+{
+    SW_FT_Outline* outline = sw_ft_outline_reset(buffer, path->points.size, path->contours);
+    plutovg_path_element_t* elements = path->elements.data;
+    plutovg_point_t* points = path->points.data;
+    plutovg_point_t p[3];
+    for(int i = 0;i < path->elements.size;i++)
+    {
+        switch(elements[i])
+        {
+        case plutovg_path_element_move_to:
+            plutovg_matrix_map_point(matrix, &points[0], &p[0]);
+            sw_ft_outline_move_to(outline, p[0].x, p[0].y);
+            points += 1;
+            break;
+        case plutovg_path_element_line_to:
+            plutovg_matrix_map_point(matrix, &points[0], &p[0]);
+            sw_ft_outline_line_to(outline, p[0].x, p[0].y);
+            points += 1;
+            break;
+        case plutovg_path_element_cubic_to:
+            plutovg_matrix_map_point(matrix, &points[0], &p[0]);
+            plutovg_matrix_map_point(matrix, &points[1], &p[1]);
+            plutovg_matrix_map_point(matrix, &points[2], &p[2]);
+            sw_ft_outline_cubic_to(outline, p[0].x, p[0].y, p[1].x, p[1].y, p[2].x, p[2].y);
+            points += 3;
+            break;
+        case plutovg_path_element_close:
+            sw_ft_outline_close(outline);
+            points += 1;
+            break;
+        }
+    }
+
+    sw_ft_outline_end(outline);
+    return outline;
+}
+
+static SW_FT_Outline* sw_ft_outline_convert_dash(sw_ft_outline_buffer_t* buffer, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_dash_t* dash)
+{
+    plutovg_path_t* dashed = plutovg_dash_path(dash, path);
+    SW_FT_Outline* outline = sw_ft_outline_convert(buffer, dashed, matrix);
+    plutovg_path_destroy(dashed);
+    return outline;
+}
+
+/*
+ * Each plutovg_t keeps one raster object. Its render pool grows until the
+ * largest outline seen so far fits in a single band and is reused for every
+ * later fill, stroke and clip, instead of a fixed pool on the stack that
+ * splits big shapes into bands and decomposes the outline once per band.
+ * The outlines and the stroker are scratch storage of the same kind: they
+ * are reset for each shape and only reallocated when a bigger one comes.
+ */
+struct plutovg_raster {
+    SW_FT_Raster raster;
+    SW_FT_Stroker stroker;
+    sw_ft_outline_buffer_t outline;
+    sw_ft_outline_buffer_t stroke_outline;
+};
+
+plutovg_raster_t* plutovg_raster_create(void)
+{
+    plutovg_raster_t* raster = malloc(sizeof(plutovg_raster_t));
+    sw_ft_grays_raster.raster_new(&raster->raster);
+    SW_FT_Stroker_New(&raster->stroker);
+    sw_ft_outline_init(&raster->outline);
+    sw_ft_outline_init(&raster->stroke_outline);
+    return raster;
+}
+
+void plutovg_raster_destroy(plutovg_raster_t* raster)
+{
+    if(raster==NULL)
+        return;
+
+    sw_ft_grays_raster.raster_done(raster->raster);
+    SW_FT_Stroker_Done(raster->stroker);
+    sw_ft_outline_done(&raster->outline);
+    sw_ft_outline_done(&raster->stroke_outline);
+    free(raster);
+}
+
+long plutovg_raster_get_retries(const plutovg_raster_t* raster)
+{
+    return SW_FT_Raster_GetRetries(raster->raster);
+}
+
+static void generation_callback(int count, const SW_FT_Span* spans, void* user)
+{
+    plutovg_rle_t* rle = user;
+    plutovg_array_ensure(rle->spans, count);
+    plutovg_span_t* data = rle->spans.data + rle->spans.size;
+    memcpy(data, spans, (size_t)count * sizeof(plutovg_span_t));
+    rle->spans.size += count;
+}
+
+static void bbox_callback(int x, int y, int w, int h, void* user)
+{
+    plutovg_rle_t* rle = user;
+    rle->x = x;
+    rle->y = y;
+    rle->w = w;
+    rle->h = h;
+}
+
+plutovg_rle_t* plutovg_rle_create(void)
+{
+    plutovg_rle_t* rle = malloc(sizeof(plutovg_rle_t));
+    plutovg_array_init(rle->spans);
+    rle->x = 0;
+    rle->y = 0;
+    rle->w = 0;
+    rle->h = 0;
+    return rle;
+}
+
+void plutovg_rle_destroy(plutovg_rle_t* rle)
+{
+    if(rle==NULL)
+        return;
+
+    free(rle->spans.data);
+    free(rle);
+}
+
+/*
+ * An outline made of one axis-aligned rectangle, which is what rects,
+ * backgrounds and clip rects become under translate and scale transforms,
+ * is not sent through the gray raster. Every pixel of a row then has the
+ * same vertical coverage, so the spans are written directly with the
+ * coverage the raster would have computed from the same 26.6 coordinates.
+ * The raster shifts a signed area, so partial pixels round up when the
+ * left edge runs towards smaller y and down otherwise; `bias` keeps that.
+ */
+static int sw_ft_outline_rect(const SW_FT_Outline* ft, SW_FT_BBox* box, int* bias)
+{
+    if(ft->n_contours != 1 || ft->n_points < 4 || ft->n_points > 6)
+        return 0;
+
+    /* closing points that repeat the first one add nothing */
+    const SW_FT_Vector* p = ft->points;
+    for(int i = 0;i < ft->n_points;i++)
+    {
+        if(ft->tags[i] != SW_FT_CURVE_TAG_ON)
+            return 0;
+        if(i >= 4 && (p[i].x != p[0].x || p[i].y != p[0].y))
+            return 0;
+    }
+
+    if(!(p[0].x == p[1].x && p[1].y == p[2].y && p[2].x == p[3].x && p[3].y == p[0].y)
+        && !(p[0].y == p[1].y && p[1].x == p[2].x && p[2].y == p[3].y && p[3].x == p[0].x))
+        return 0;
+
+    box->xMin = p[0].x < p[2].x ? p[0].x : p[2].x;
+    box->xMax = p[0].x < p[2].x ? p[2].x : p[0].x;
+    box->yMin = p[0].y < p[2].y ? p[0].y : p[2].y;
+    box->yMax = p[0].y < p[2].y ? p[2].y : p[0].y;
+
+    *bias = 0;
+    for(int i = 0;i < 4;i++)
+    {
+        const SW_FT_Vector* a = &p[i];
+        const SW_FT_Vector* b = &p[(i + 1) & 3];
+        if(a->x == box->xMin && b->x == box->xMin && b->y < a->y)
+            *bias = 255;
+    }
+
+    return 1;
+}
+
+static void rle_add_span(plutovg_rle_t* rle, int x, int len, int y, int coverage)
+{
+    if(len <= 0 || coverage == 0)
+        return;
+
+    if(coverage > 255)
+        coverage = 255;
+
+    plutovg_span_t* span = rle->spans.data + rle->spans.size;
+    if(rle->spans.size > 0 && span[-1].y == y && span[-1].x + span[-1].len == x && span[-1].coverage == coverage)
+    {
+        span[-1].len = (unsigned short)(span[-1].len + len);
+        return;
+    }
+
+    span->x = (short)x;
+    span->y = (short)y;
+    span->len = (unsigned short)len;
+    span->coverage = (unsigned char)coverage;
+    ++rle->spans.size;
+}
+
+static void rle_generate_rect(plutovg_rle_t* rle, const SW_FT_BBox* box, const SW_FT_BBox* clip, int bias)
+{
+    /* edges in 1/256 pixel units, as in the raster */
+    SW_FT_Pos x1 = box->xMin * 4;
+    SW_FT_Pos x2 = box->xMax * 4;
+    SW_FT_Pos y1 = box->yMin * 4;
+    SW_FT_Pos y2 = box->yMax * 4;
+
+    SW_FT_Pos l = x1 >> 8;
+    SW_FT_Pos r = (x2 - 1) >> 8;
+    SW_FT_Pos t = y1 >> 8;
+    SW_FT_Pos b = (y2 - 1) >> 8;
+    if(l < clip->xMin) l = clip->xMin;
+    if(r > clip->xMax - 1) r = clip->xMax - 1;
+    if(t < clip->yMin) t = clip->yMin;
+    if(b > clip->yMax - 1) b = clip->yMax - 1;
+
+    int start = rle->spans.size;
+    if(x1 < x2 && y1 < y2 && l <= r && t <= b)
+    {
+        /* coverage widths of the first and last columns */
+        int lw = (int)((l + 1) * 256 - x1);
+        int rw = (int)(x2 - r * 256);
+        if(lw > 256) lw = 256;
+        if(rw > 256) rw = 256;
+        if(l == r) lw = rw = (int)((x2 < (r + 1) * 256 ? x2 : (r + 1) * 256) - (x1 > l * 256 ? x1 : l * 256));
+
+        plutovg_array_ensure(rle->spans, (int)(b - t + 1) * 3);
+        for(SW_FT_Pos y = t;y <= b;y++)
+        {
+            SW_FT_Pos top = y * 256 > y1 ? y * 256 : y1;
+            SW_FT_Pos bottom = (y + 1) * 256 < y2 ? (y + 1) * 256 : y2;
+            int h = (int)(bottom - top);
+            rle_add_span(rle, (int)l, 1, (int)y, (lw * h + bias) >> 8);
+            if(l < r)
+            {
+                rle_add_span(rle, (int)l + 1, (int)(r - l - 1), (int)y, h);
+                rle_add_span(rle, (int)r, 1, (int)y, (rw * h + bias) >> 8);
+            }
+        }
+    }
+
+    if(rle->spans.size == start)
+        return;
+
+    plutovg_span_t* spans = rle->spans.data + start;
+    int x_min = INT_MAX, x_max = INT_MIN;
+    for(int i = 0;i < rle->spans.size - start;i++)
+    {
+        if(spans[i].x < x_min) x_min = spans[i].x;
+        if(spans[i].x + spans[i].len > x_max) x_max = spans[i].x + spans[i].len;
+    }
+
+    rle->x = x_min;
+    rle->y = spans[0].y;
+    rle->w = x_max - x_min;
+    rle->h = rle->spans.data[rle->spans.size - 1].y - rle->y + 1;
+}
+
+#define SQRT2 1.41421356237309504880
+void plutovg_rle_rasterize(plutovg_rle_t* rle, plutovg_raster_t* raster, const plutovg_path_t* path, const plutovg_matrix_t* matrix, const plutovg_rect_t* clip, const plutovg_stroke_data_t* stroke, plutovg_fill_rule_t winding)
+{
+    SW_FT_Raster_Params params;
+    params.flags = SW_FT_RASTER_FLAG_DIRECT | SW_FT_RASTER_FLAG_AA;
+    params.gray_spans = generation_callback;
+    params.bbox_cb = bbox_callback;
+    params.user = rle;
+
+    if(clip)
+    {
+        params.flags |= SW_FT_RASTER_FLAG_CLIP;
+        params.clip_box.xMin = (SW_FT_Pos)clip->x;
+        params.clip_box.yMin = (SW_FT_Pos)clip->y;
+        params.clip_box.xMax = (SW_FT_Pos)(clip->x + clip->w);
+        params.clip_box.yMax = (SW_FT_Pos)(clip->y + clip->h);
+    }
+
+    if(stroke)
+    {
+        SW_FT_Outline* outline = stroke->dash ? sw_ft_outline_convert_dash(&raster->outline, path, matrix, stroke->dash) : sw_ft_outline_convert(&raster->outline, path, matrix);
+        SW_FT_Stroker_LineCap ftCap;
+        SW_FT_Stroker_LineJoin ftJoin;
+        SW_FT_Fixed ftWidth;
+        SW_FT_Fixed ftMiterLimit;
+
+        plutovg_point_t p1 = {0, 0};
+        plutovg_point_t p2 = {SQRT2, SQRT2};
+        plutovg_point_t p3;
+
+        plutovg_matrix_map_point(matrix, &p1, &p1);
+        plutovg_matrix_map_point(matrix, &p2, &p2);
+
+        p3.x = p2.x - p1.x;
+        p3.y = p2.y - p1.y;
+
+        double scale = sqrt(p3.x*p3.x + p3.y*p3.y) / 2.0;
+
+        ftWidth = (SW_FT_Fixed)(stroke->width * scale * 0.5 * (1 << 6));
+        ftMiterLimit = (SW_FT_Fixed)(stroke->miterlimit * (1 << 16));
+
+        switch(stroke->cap)
+        {
+        case plutovg_line_cap_square:
+            ftCap = SW_FT_STROKER_LINECAP_SQUARE;
+            break;
+        case plutovg_line_cap_round:
+            ftCap = SW_FT_STROKER_LINECAP_ROUND;
+            break;
+        default:
+            ftCap = SW_FT_STROKER_LINECAP_BUTT;
+            break;
+        }
+
+        switch(stroke->join)
+        {
+        case plutovg_line_join_bevel:
+            ftJoin = SW_FT_STROKER_LINEJOIN_BEVEL;
+            break;
+        case plutovg_line_join_round:
+            ftJoin = SW_FT_STROKER_LINEJOIN_ROUND;
+            break;
+        default:
+            ftJoin = SW_FT_STROKER_LINEJOIN_MITER_FIXED;
+            break;
+        }
+
+        SW_FT_Stroker stroker = raster->stroker;
+        SW_FT_Stroker_Set(stroker, ftWidth, ftCap, ftJoin, ftMiterLimit);
+        SW_FT_Stroker_ParseOutline(stroker, outline);
+
+        SW_FT_UInt points;
+        SW_FT_UInt contours;
+        SW_FT_Stroker_GetCounts(stroker, &points, &contours);
+
+        SW_FT_Outline* strokeOutline = sw_ft_outline_reset(&raster->stroke_outline, (int)points, (int)contours);
+        SW_FT_Stroker_Export(stroker, strokeOutline);
+
+        strokeOutline->flags = SW_FT_OUTLINE_NONE;
+        params.source = strokeOutline;
+        sw_ft_grays_raster.raster_render(raster->raster, &params);
+    }
+    else
+    {
+        SW_FT_Outline* outline = sw_ft_outline_convert(&raster->outline, path, matrix);
+        SW_FT_BBox box;
+        int bias;
+        if(clip && sw_ft_outline_rect(outline, &box, &bias))
+        {
+            rle_generate_rect(rle, &box, &params.clip_box, bias);
+            return;
+        }
+
+        outline->flags = winding == plutovg_fill_rule_even_odd ? SW_FT_OUTLINE_EVEN_ODD_FILL : SW_FT_OUTLINE_NONE;
+        params.source = outline;
+        sw_ft_grays_raster.raster_render(raster->raster, &params);
+    }
+}
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define DIV255(x) (((x) + ((x) >> 8) + 0x80) >> 8)
+plutovg_rle_t* plutovg_rle_intersection(const plutovg_rle_t* a, const plutovg_rle_t* b)
+{
+    // Each span written moves past a span of a or b, so a row can hold more
+    // spans than either input, as where two antialiased edges cross.
+    int count = a->spans.size + b->spans.size;
+    plutovg_rle_t* result = malloc(sizeof(plutovg_rle_t));
+    plutovg_array_init(result->spans);
+    plutovg_array_ensure(result->spans, count);
+
+    plutovg_span_t* a_spans = a->spans.data;
+    plutovg_span_t* a_end = a_spans + a->spans.size;
+
+    plutovg_span_t* b_spans = b->spans.data;
+    plutovg_span_t* b_end = b_spans + b->spans.size;
+
+    while(count && a_spans < a_end && b_spans < b_end)
+    {
+        if(b_spans->y > a_spans->y)
+        {
+            ++a_spans;
+            continue;
+        }
+
+        if(a_spans->y != b_spans->y)
+        {
+            ++b_spans;
+            continue;
+        }
+
+        int ax1 = a_spans->x;
+        int ax2 = ax1 + a_spans->len;
+        int bx1 = b_spans->x;
+        int bx2 = bx1 + b_spans->len;
+
+        if(bx1 < ax1 && bx2 < ax1)
+        {
+            ++b_spans;
+            continue;
+        }
+        else if(ax1 < bx1 && ax2 < bx1)
+        {
+            ++a_spans;
+            continue;
+        }
+
+        int x = MAX(ax1, bx1);
+        int len = MIN(ax2, bx2) - x;
+        if(len)
+        {
+            plutovg_span_t* span = result->spans.data + result->spans.size;
+            span->x = (short)x;
+            span->len = (unsigned short)len;
+            span->y = a_spans->y;
+            span->coverage = DIV255(a_spans->coverage * b_spans->coverage);
+            ++result->spans.size;
+            --count;
+        }
+
+        if(ax2 < bx2)
+        {
+            ++a_spans;
+        }
+        else
+        {
+            ++b_spans;
+        }
+    }
+
+    if(result->spans.size==0)
+    {
+        result->x = 0;
+        result->y = 0;
+        result->w = 0;
+        result->h = 0;
+        return result;
+    }
+
+    plutovg_span_t* spans = result->spans.data;
+    int x1 = INT_MAX;
+    int y1 = spans[0].y;
+    int x2 = 0;
+    int y2 = spans[result->spans.size - 1].y;
+    for(int i = 0;i < result->spans.size;i++)
+    {
+        if(spans[i].x < x1) x1 = spans[i].x;
+        if(spans[i].x + spans[i].len > x2) x2 = spans[i].x + spans[i].len;
+    }
+
+    result->x = x1;
+    result->y = y1;
+    result->w = x2 - x1;
+    result->h = y2 - y1 + 1;
+    return result;
+}
+
+void plutovg_rle_clip_path(plutovg_rle_t* rle, const plutovg_rle_t* clip)
+{
+    if(rle==NULL || clip==NULL)
+        return;
+
+    plutovg_rle_t* result = plutovg_rle_intersection(rle, clip);
+    plutovg_array_ensure(rle->spans, result->spans.size);
+    memcpy(rle->spans.data, result->spans.data, (size_t)result->spans.size * sizeof(plutovg_span_t));
+    rle->spans.size = result->spans.size;
+    rle->x = result->x;
+    rle->y = result->y;
+    rle->w = result->w;
+    rle->h = result->h;
+    plutovg_rle_destroy(result);
+}
+
+plutovg_rle_t* plutovg_rle_clone(const plutovg_rle_t* rle)
+{
+    if(rle==NULL)
+        return NULL;
+
+    plutovg_rle_t* result = malloc(sizeof(plutovg_rle_t));
+    plutovg_array_init(result->spans);
+    plutovg_array_ensure(result->spans, rle->spans.size);
+
+    memcpy(result->spans.data, rle->spans.data, (size_t)rle->spans.size * sizeof(plutovg_span_t));
+    result->spans.size = rle->spans.size;
+    result->x = rle->x;
+    result->y = rle->y;
+    result->w = rle->w;
+    result->h = rle->h;
+    return result;
+}
+
+void plutovg_rle_clear(plutovg_rle_t* rle)
+{
+    rle->spans.size = 0;
+    rle->x = 0;
+    rle->y = 0;
+    rle->w = 0;
+    rle->h = 0;
+}
@@ -121,6 +121,7 @@ plutovg_t* plutovg_create(plutovg_surface_t* surface)
     pluto->path = plutovg_path_create();
     pluto->rle = plutovg_rle_create();
     pluto->clippath = NULL;
+    pluto->raster = plutovg_raster_create();
     pluto->clip.x = 0.0;
     pluto->clip.y = 0.0;
     pluto->clip.w = surface->width;
@@ -152,6 +153,7 @@ void plutovg_destroy(plutovg_t* pluto)
         plutovg_path_destroy(pluto->path);
         plutovg_rle_destroy(pluto->rle);
         plutovg_rle_destroy(pluto->clippath);
+        plutovg_raster_destroy(pluto->raster);
         free(pluto);
     }
 }
@@ -161,6 +163,11 @@ int plutovg_get_reference_count(const plutovg_t* pluto)
     return pluto->ref;
 }
 
+long plutovg_get_raster_retries(const plutovg_t* pluto)
+{
+    return plutovg_raster_get_retries(pluto->raster);
+}
+
 void plutovg_save(plutovg_t* pluto)
 {
     plutovg_state_t* newstate = plutovg_state_clone(pluto->state);
@@ -448,7 +455,7 @@ void plutovg_paint(plutovg_t* pluto)
         plutovg_matrix_t matrix;
         plutovg_matrix_init_identity(&matrix);
         pluto->clippath = plutovg_rle_create();
-        plutovg_rle_rasterize(pluto->clippath, path, &matrix, &pluto->clip, NULL, plutovg_fill_rule_non_zero);
+        plutovg_rle_rasterize(pluto->clippath, pluto->raster, path, &matrix, &pluto->clip, NULL, plutovg_fill_rule_non_zero);
         plutovg_path_destroy(path);
     }
 
@@ -460,7 +467,7 @@ void plutovg_fill_preserve(plutovg_t* pluto)
 {
     plutovg_state_t* state = pluto->state;
     plutovg_rle_clear(pluto->rle);
-    plutovg_rle_rasterize(pluto->rle, pluto->path, &state->matrix, &pluto->clip, NULL, state->winding);
+    plutovg_rle_rasterize(pluto->rle, pluto->raster, pluto->path, &state->matrix, &pluto->clip, NULL, state->winding);
     plutovg_rle_clip_path(pluto->rle, state->clippath);
     plutovg_blend(pluto, pluto->rle);
 }
@@ -469,7 +476,7 @@ void plutovg_stroke_preserve(plutovg_t* pluto)
 {
     plutovg_state_t* state = pluto->state;
     plutovg_rle_clear(pluto->rle);
-    plutovg_rle_rasterize(pluto->rle, pluto->path, &state->matrix, &pluto->clip, &state->stroke, plutovg_fill_rule_non_zero);
+    plutovg_rle_rasterize(pluto->rle, pluto->raster, pluto->path, &state->matrix, &pluto->clip, &state->stroke, plutovg_fill_rule_non_zero);
     plutovg_rle_clip_path(pluto->rle, state->clippath);
     plutovg_blend(pluto, pluto->rle);
 }
@@ -480,13 +487,13 @@ void plutovg_clip_preserve(plutovg_t* pluto)
     if(state->clippath)
     {
         plutovg_rle_clear(pluto->rle);
-        plutovg_rle_rasterize(pluto->rle, pluto->path, &state->matrix, &pluto->clip, NULL, state->winding);
+        plutovg_rle_rasterize(pluto->rle, pluto->raster, pluto->path, &state->matrix, &pluto->clip, NULL, state->winding);
         plutovg_rle_clip_path(state->clippath, pluto->rle);
     }
     else
     {
         state->clippath = plutovg_rle_create();
-        plutovg_rle_rasterize(state->clippath, pluto->path, &state->matrix, &pluto->clip, NULL, state->winding);
+        plutovg_rle_rasterize(state->clippath, pluto->raster, pluto->path, &state->matrix, &pluto->clip, NULL, state->winding);
     }
 }
 
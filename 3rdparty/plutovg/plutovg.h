@@ -218,6 +218,7 @@ plutovg_t* plutovg_create(plutovg_surface_t* surface);
 plutovg_t* plutovg_reference(plutovg_t* pluto);
 void plutovg_destroy(plutovg_t* pluto);
 int plutovg_get_reference_count(const plutovg_t* pluto);
+long plutovg_get_raster_retries(const plutovg_t* pluto);
 void plutovg_save(plutovg_t* pluto);
 void plutovg_restore(plutovg_t* pluto);
 void plutovg_set_source_rgb(plutovg_t* pluto, double r, double g, double b);
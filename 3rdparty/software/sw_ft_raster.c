@@ -70,6 +70,7 @@
 #include <limits.h>
 #include <setjmp.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #define SW_FT_UINT_MAX UINT_MAX
 #define SW_FT_INT_MAX INT_MAX
@@ -104,6 +105,10 @@ typedef ptrdiff_t SW_FT_PtrDist;
 /* to do all of its work.                                                */
 #define SW_FT_RENDER_POOL_SIZE 16384L
 
+/* The size in bytes up to which a raster object grows its own render    */
+/* pool.  Outlines needing more cells than that are rendered in bands.   */
+#define SW_FT_MAX_RENDER_POOL_SIZE (32L * 1024L * 1024L)
+
 typedef int (*SW_FT_Outline_MoveToFunc)(const SW_FT_Vector* to, void* user);
 
 #define SW_FT_Outline_MoveTo_Func SW_FT_Outline_MoveToFunc
@@ -324,6 +329,9 @@ typedef struct gray_TWorker_ {
 
     int band_size;
     int band_shoot;
+    long retries;
+
+    struct gray_TRaster_* raster;
 
     ft_jmp_buf jump_buffer;
 
@@ -348,6 +356,10 @@ static gray_TWorker ras;
 typedef struct gray_TRaster_ {
     void* memory;
 
+    void* pool;
+    long  pool_size;
+    long  retries;
+
 } gray_TRaster, *gray_PRaster;
 
 /*************************************************************************/
@@ -1195,6 +1207,33 @@ typedef struct gray_TBand_ {
 
 } gray_TBand;
 
+/*************************************************************************/
+/*                                                                       */
+/* Double the render pool of the raster object, if any, so that the      */
+/* current band can be converted again instead of being split.  The      */
+/* pool is kept for later outlines.                                      */
+/*                                                                       */
+static int gray_grow_pool(RAS_ARG)
+{
+    gray_PRaster raster = ras.raster;
+    void*        pool;
+    long         pool_size;
+
+    if (!raster || raster->pool_size >= SW_FT_MAX_RENDER_POOL_SIZE) return 0;
+
+    pool_size = raster->pool_size * 2;
+    pool = malloc((size_t)pool_size);
+    if (!pool) return 0;
+
+    free(raster->pool);
+    raster->pool = pool;
+    raster->pool_size = pool_size;
+
+    ras.buffer = pool;
+    ras.buffer_size = pool_size;
+    return 1;
+}
+
 SW_FT_DEFINE_OUTLINE_FUNCS(func_interface,
                            (SW_FT_Outline_MoveTo_Func)gray_move_to,
                            (SW_FT_Outline_LineTo_Func)gray_line_to,
@@ -1305,7 +1344,12 @@ static int gray_convert_glyph(RAS_ARG)
                 return 1;
 
         ReduceBands:
-            /* render pool overflow; we will reduce the render band by half */
+            ras.retries++;
+
+            /* render pool overflow; grow the pool if we own one, or else */
+            /* reduce the render band by half                             */
+            if (gray_grow_pool(RAS_VAR)) continue;
+
             bottom = band->min;
             top = band->max;
             middle = bottom + ((top - bottom) >> 1);
@@ -1335,7 +1379,6 @@ static int gray_convert_glyph(RAS_ARG)
 static int gray_raster_render(gray_PRaster               raster,
                               const SW_FT_Raster_Params* params)
 {
-    SW_FT_UNUSED(raster);
     const SW_FT_Outline* outline = (const SW_FT_Outline*)params->source;
 
     gray_TWorker worker[1];
@@ -1368,41 +1411,63 @@ static int gray_raster_render(gray_PRaster               raster,
         ras.clip_box.yMax = 32767L;
     }
 
-    gray_init_cells(RAS_VAR_ buffer, buffer_size);
+    /* a raster object renders into its own pool, which grows until the */
+    /* whole outline fits in a single band                              */
+    if (raster && !raster->pool) {
+        raster->pool = malloc(SW_FT_RENDER_POOL_SIZE);
+        raster->pool_size = raster->pool ? SW_FT_RENDER_POOL_SIZE : 0;
+    }
+
+    if (raster && raster->pool) {
+        gray_init_cells(RAS_VAR_ raster->pool, raster->pool_size);
+        band_size = 0x10000; /* taller than any clip box */
+        ras.raster = raster;
+    } else {
+        gray_init_cells(RAS_VAR_ buffer, buffer_size);
+        ras.raster = NULL;
+    }
 
     ras.outline = *outline;
     ras.num_cells = 0;
     ras.invalid = 1;
     ras.band_size = band_size;
+    ras.retries = 0;
     ras.num_gray_spans = 0;
 
     ras.render_span = (SW_FT_Raster_Span_Func)params->gray_spans;
     ras.render_span_data = params->user;
 
     gray_convert_glyph(RAS_VAR);
+    if (raster) raster->retries += ras.retries;
     params->bbox_cb(ras.bound_left, ras.bound_top,
                     ras.bound_right - ras.bound_left,
                     ras.bound_bottom - ras.bound_top + 1, params->user);
     return 1;
 }
 
-/**** RASTER OBJECT CREATION: In stand-alone mode, we simply use *****/
-/****                         a static object.                   *****/
+/**** RASTER OBJECT CREATION: Each raster object owns a render  *****/
+/****                         pool; rendering with a NULL raster *****/
+/****                         uses a fixed pool on the stack.    *****/
 
 static int gray_raster_new(SW_FT_Raster* araster)
 {
-    static gray_TRaster the_raster;
+    gray_PRaster raster = (gray_PRaster)malloc(sizeof(gray_TRaster));
 
-    *araster = (SW_FT_Raster)&the_raster;
-    SW_FT_MEM_ZERO(&the_raster, sizeof(the_raster));
+    *araster = (SW_FT_Raster)raster;
+    if (!raster) return SW_FT_THROW(Memory_Overflow);
 
+    SW_FT_MEM_ZERO(raster, sizeof(*raster));
     return 0;
 }
 
 static void gray_raster_done(SW_FT_Raster raster)
 {
-    /* nothing */
-    SW_FT_UNUSED(raster);
+    gray_PRaster praster = (gray_PRaster)raster;
+
+    if (!praster) return;
+
+    free(praster->pool);
+    free(praster);
 }
 
 static void gray_raster_reset(SW_FT_Raster raster, char* pool_base,
@@ -1420,4 +1485,9 @@ SW_FT_DEFINE_RASTER_FUNCS(sw_ft_grays_raster,
                           (SW_FT_Raster_Render_Func)gray_raster_render,
                           (SW_FT_Raster_Done_Func)gray_raster_done)
 
+long SW_FT_Raster_GetRetries(SW_FT_Raster raster)
+{
+    return raster ? ((gray_PRaster)raster)->retries : 0;
+}
+
 /* END */
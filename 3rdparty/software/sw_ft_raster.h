@@ -604,4 +604,17 @@ SW_FT_Outline_Get_CBox( const SW_FT_Outline*  outline,
 
 extern const SW_FT_Raster_Funcs   sw_ft_grays_raster;
 
+  /*************************************************************************/
+  /*                                                                       */
+  /* <Function>                                                            */
+  /*    SW_FT_Raster_GetRetries                                            */
+  /*                                                                       */
+  /* <Description>                                                         */
+  /*    Returns how many times a band ran out of cells in the render pool  */
+  /*    of `raster' and was converted again, either with a grown pool or   */
+  /*    split in two, since the raster object was created.                 */
+  /*                                                                       */
+  long
+  SW_FT_Raster_GetRetries( SW_FT_Raster  raster );
+
 #endif // SW_FT_IMG_H
@@ -0,0 +1,117 @@
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+
+#include <lunasvg.h>
+
+using namespace lunasvg;
+
+int help()
+{
+    std::cout << "Usage: \n   svgbench [filename] [resolution] [iterations] [threads]\n\nExamples: \n    $ svgbench input.svg\n    $ svgbench input.svg 512x512\n    $ svgbench input.svg 512x512 200\n    $ svgbench input.svg 8192x8192 10 0\n\n";
+    return 1;
+}
+
+bool setup(int argc, char** argv, std::string& filename, std::uint32_t& width, std::uint32_t& height, std::uint32_t& iterations, std::uint32_t& threads)
+{
+    if(argc > 1) filename.assign(argv[1]);
+    if(argc > 2)
+    {
+        std::stringstream ss;
+
+        ss << argv[2];
+        ss >> width;
+
+        if(ss.fail() || ss.get() != 'x')
+            return false;
+
+        ss >> height;
+    }
+
+    if(argc > 3)
+    {
+        std::stringstream ss;
+
+        ss << argv[3];
+        ss >> iterations;
+
+        if(ss.fail() || iterations == 0)
+            return false;
+    }
+
+    if(argc > 4)
+    {
+        std::stringstream ss;
+
+        ss << argv[4];
+        ss >> threads;
+
+        if(ss.fail())
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::string filename;
+    std::uint32_t width = 0, height = 0;
+    std::uint32_t iterations = 100;
+    std::uint32_t threads = 1;
+    if(!setup(argc, argv, filename, width, height, iterations, threads)) return help();
+
+    auto document = Document::loadFromFile(filename);
+    if(!document) return help();
+
+    if(width == 0 && height == 0)
+    {
+        width = static_cast<std::uint32_t>(document->width() + 0.5);
+        height = static_cast<std::uint32_t>(document->height() + 0.5);
+    }
+    else if(height == 0)
+    {
+        height = static_cast<std::uint32_t>(width * document->height() / document->width() + 0.5);
+    }
+    else if(width == 0)
+    {
+        width = static_cast<std::uint32_t>(height * document->width() / document->height() + 0.5);
+    }
+
+    if(width == 0 || height == 0) return help();
+
+    // One bitmap is reused for every frame, as a thumbnailer rendering into
+    // its own buffers would, so the loop measures rasterization alone.
+    // A thread count other than 1 selects the tiled renderer, 0 meaning one
+    // worker per hardware thread.
+    Bitmap bitmap(width, height);
+    Matrix matrix(width / document->width(), 0, 0, height / document->height(), 0, 0);
+    auto render = [&] {
+        if(threads == 1)
+            document->render(bitmap, matrix);
+        else
+            document->render(bitmap, matrix, threads);
+    };
+
+    bitmap.clear(0);
+    render();
+
+    auto wallStart = std::chrono::steady_clock::now();
+    auto cpuStart = std::clock();
+    for(std::uint32_t i = 0; i < iterations; ++i)
+    {
+        bitmap.clear(0);
+        render();
+    }
+
+    auto cpuSeconds = double(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    auto wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    std::cout << filename << " @ " << width << "x" << height << ": "
+              << iterations << " frames, "
+              << (wallSeconds * 1000.0 / iterations) << " ms/frame, "
+              << (iterations / cpuSeconds) << " images/s/core" << std::endl;
+
+    return 0;
+}
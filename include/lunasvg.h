@@ -23,6 +23,7 @@
 #ifndef LUNASVG_H
 #define LUNASVG_H
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -97,6 +98,13 @@ public:
     double f{0};
 };
 
+enum class PixelFormat
+{
+    RGBA8, ///< R, G, B, A bytes, not premultiplied
+    BGRA8, ///< B, G, R, A bytes, not premultiplied
+    A8     ///< one alpha byte per pixel
+};
+
 class LUNASVG_API Bitmap
 {
 public:
@@ -115,9 +123,21 @@ public:
     std::uint32_t height() const;
     std::uint32_t stride() const;
 
-    void clear(std::uint32_t color);
-    void convert(int ri, int gi, int bi, int ai, bool unpremultiply);
-    void convertToRGBA() { convert(0, 1, 2, 3, true); }
+    /**
+     * @param threadCount - number of threads to use on large bitmaps, 0 for one per hardware thread
+     */
+    void clear(std::uint32_t color, std::uint32_t threadCount = 1);
+    void convert(int ri, int gi, int bi, int ai, bool unpremultiply, std::uint32_t threadCount = 1);
+    void convertToRGBA(std::uint32_t threadCount = 1) { convert(0, 1, 2, 3, true, threadCount); }
+
+    /**
+     * @brief Writes the pixels to another buffer in a single pass
+     * @param format - format of the pixels written
+     * @param data - buffer of height() rows of stride bytes
+     * @param stride - bytes per row of data
+     * @param threadCount - number of threads to use on large bitmaps, 0 for one per hardware thread
+     */
+    void convertTo(PixelFormat format, std::uint8_t* data, std::uint32_t stride, std::uint32_t threadCount = 1) const;
 
     bool valid() const { return !!m_impl; }
 
@@ -127,6 +147,7 @@ private:
 };
 
 class LayoutSymbol;
+class MemoryArena;
 
 class LUNASVG_API Document
 {
@@ -260,13 +281,49 @@ public:
      */
     std::vector<vg::CommandListHandle> renderToBitmap(vg::CommandListRef cl) const;
 
+    /**
+     * @brief Rasterizes the document on the CPU into a caller-owned bitmap
+     * @param bitmap - target image on which the content will be drawn, in place
+     * @param matrix - the current transformation matrix
+     */
+    void render(Bitmap bitmap, const Matrix& matrix = Matrix{}) const;
+
+    /**
+     * @brief Rasterizes the document on the CPU, splitting the bitmap into tiles rendered in parallel
+     * @param bitmap - target image on which the content will be drawn, in place
+     * @param matrix - the current transformation matrix
+     * @param threadCount - number of threads to use, 0 for one per hardware thread
+     */
+    void render(Bitmap bitmap, const Matrix& matrix, std::uint32_t threadCount) const;
+
+    /**
+     * @brief Rasterizes the document on the CPU into a new bitmap
+     * @param width - maximum width, in pixels
+     * @param height - maximum height, in pixels
+     * @param backgroundColor - background color in 0xRRGGBBAA format
+     * @return the raster representation of the document
+     */
+    Bitmap renderToBitmap(std::uint32_t width = 0, std::uint32_t height = 0, std::uint32_t backgroundColor = 0x00000000) const;
+
+    /**
+     * @brief Returns the memory held by the document's layout tree
+     * @return the number of bytes reserved by the document's arena
+     */
     size_t estimateMemoryUsage() const;
 
+    /**
+     * @brief Returns how many group layers renders of the document have skipped so far
+     * @return the number of groups drawn onto their parent, opacity multiplied into their paints and rectangular clips as scissors
+     */
+    size_t elidedLayerCount() const;
+
     ~Document();
 private:
     Document();
 
-    std::unique_ptr<LayoutSymbol> root;
+    std::unique_ptr<MemoryArena> arena;
+    LayoutSymbol* root{nullptr};
+    mutable std::atomic<size_t> elidedLayers{0};
 };
 
 } //namespace lunasvg
@@ -0,0 +1,73 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace lunasvg {
+
+static const std::size_t MaxBlockSize = 256 * 1024;
+
+MemoryArena::~MemoryArena()
+{
+    release();
+}
+
+void MemoryArena::release()
+{
+    for(auto finalizer = m_finalizers; finalizer; finalizer = finalizer->next)
+        finalizer->destroy(finalizer->object);
+
+    auto block = m_blocks;
+    while(block)
+    {
+        auto next = block->next;
+        std::free(block);
+        block = next;
+    }
+
+    m_blocks = nullptr;
+    m_finalizers = nullptr;
+    m_ptr = nullptr;
+    m_end = nullptr;
+    m_nextBlockSize = 4096;
+    m_bytesUsed = 0;
+    m_bytesReserved = 0;
+}
+
+void MemoryArena::addFinalizer(void* object, void (*destroy)(void*))
+{
+    auto finalizer = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+    finalizer->next = m_finalizers;
+    finalizer->destroy = destroy;
+    finalizer->object = object;
+    m_finalizers = finalizer;
+}
+
+void* MemoryArena::allocateSlow(std::size_t size, std::size_t alignment)
+{
+    // Block sizes double up to a cap, so small documents stay small and large
+    // ones do not pay a malloc per object. Oversized requests get their own
+    // block without disturbing the current one.
+    auto header = (sizeof(Block) + alignment - 1) & ~(alignment - 1);
+    auto blockSize = std::max(m_nextBlockSize, header + size);
+    auto block = static_cast<Block*>(std::malloc(blockSize));
+    if(block == nullptr)
+        throw std::bad_alloc();
+
+    m_bytesReserved += blockSize;
+    m_bytesUsed += size;
+
+    block->next = m_blocks;
+    m_blocks = block;
+
+    auto data = reinterpret_cast<char*>(block) + header;
+    if(blockSize > m_nextBlockSize)
+        return data;
+
+    m_ptr = data + size;
+    m_end = reinterpret_cast<char*>(block) + blockSize;
+    m_nextBlockSize = std::min(m_nextBlockSize * 2, MaxBlockSize);
+    return data;
+}
+
+} // namespace lunasvg
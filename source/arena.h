@@ -0,0 +1,80 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace lunasvg {
+
+// Monotonic block allocator. Objects are bump-allocated and never freed one by
+// one; destructors that actually do something are queued and run in reverse
+// order when the arena is released, after which every block goes back at once.
+class MemoryArena
+{
+public:
+    MemoryArena() = default;
+    ~MemoryArena();
+
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment);
+
+    template<typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        auto object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if(!std::is_trivially_destructible<T>::value)
+            addFinalizer(object, [](void* object) { static_cast<T*>(object)->~T(); });
+        return object;
+    }
+
+    void release();
+
+    std::size_t bytesUsed() const { return m_bytesUsed; }
+    std::size_t bytesReserved() const { return m_bytesReserved; }
+
+private:
+    struct Block
+    {
+        Block* next;
+    };
+
+    struct Finalizer
+    {
+        Finalizer* next;
+        void (*destroy)(void*);
+        void* object;
+    };
+
+    void addFinalizer(void* object, void (*destroy)(void*));
+    void* allocateSlow(std::size_t size, std::size_t alignment);
+
+    Block* m_blocks{nullptr};
+    Finalizer* m_finalizers{nullptr};
+    char* m_ptr{nullptr};
+    char* m_end{nullptr};
+    std::size_t m_nextBlockSize{4096};
+    std::size_t m_bytesUsed{0};
+    std::size_t m_bytesReserved{0};
+};
+
+inline void* MemoryArena::allocate(std::size_t size, std::size_t alignment)
+{
+    auto address = reinterpret_cast<std::uintptr_t>(m_ptr);
+    auto padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+    if(m_ptr == nullptr || size + padding > static_cast<std::size_t>(m_end - m_ptr))
+        return allocateSlow(size, alignment);
+
+    auto data = m_ptr + padding;
+    m_ptr = data + size;
+    m_bytesUsed += size + padding;
+    return data;
+}
+
+} // namespace lunasvg
+
+#endif // ARENA_H
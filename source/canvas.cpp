@@ -1,33 +1,82 @@
 #include "canvas.h"
+#include "plutovg.h"
 
 #include <cmath>
+#include <algorithm>
 #include <vg_util.h>
 
 namespace lunasvg {
 
-std::shared_ptr<Canvas> Canvas::create(vg::CommandListRef cl, double x, double y, double width, double height)
+static Rect pixelBox(double x, double y, double width, double height)
 {
     if (width <= 0.0 || height <= 0.0)
-        return std::shared_ptr<Canvas>(new Canvas(cl, 0, 0, 1, 1));
+        return Rect{0, 0, 1, 1};
+
+    auto l = floor(x);
+    auto t = floor(y);
+    auto r = ceil(x + width);
+    auto b = ceil(y + height);
+    return Rect{l, t, r - l, b - t};
+}
+
+std::shared_ptr<Canvas> Canvas::create(vg::CommandListRef cl, double x, double y, double width, double height)
+{
+    auto res = std::shared_ptr<Canvas>(new Canvas(cl, pixelBox(x, y, width, height)));
+    vg::clSetScissor(cl, res->rect.x, res->rect.y, res->rect.w, res->rect.h);
+    res->scissor = res->rect;
+    return res;
+}
+
+std::shared_ptr<Canvas> Canvas::create(unsigned char* data, unsigned int width, unsigned int height, unsigned int stride)
+{
+    return create(data, 0, 0, width, height, stride);
+}
 
-    auto l = static_cast<int>(floor(x));
-    auto t = static_cast<int>(floor(y));
-    auto r = static_cast<int>(ceil(x + width));
-    auto b = static_cast<int>(ceil(y + height));
-    return std::shared_ptr<Canvas>(new Canvas(cl, l, t, r - l, b - t));
+std::shared_ptr<Canvas> Canvas::create(unsigned char* data, int x, int y, unsigned int width, unsigned int height, unsigned int stride)
+{
+    // data points at pixel (x, y) of a larger image; drawing stays in that
+    // image's coordinates and is clipped to the width by height window.
+    auto surface = plutovg_surface_create_for_data(data, static_cast<int>(width), static_cast<int>(height), static_cast<int>(stride));
+    return std::shared_ptr<Canvas>(new Canvas(surface, Rect{(double)x, (double)y, (double)width, (double)height}));
 }
 
 std::shared_ptr<Canvas> Canvas::create(std::shared_ptr<Canvas> parent, double x, double y, double width, double height)
 {
+    if (parent->isRaster()) {
+        auto box = pixelBox(x, y, width, height);
+        auto surface = plutovg_surface_create(static_cast<int>(box.w), static_cast<int>(box.h));
+        auto res = std::shared_ptr<Canvas>(new Canvas(surface, box));
+        res->root = parent->root;
+        return res;
+    }
+
     auto handle = vg::createCommandList(parent->cl.m_Context, vg::CommandListFlags::Cacheable);
-    auto res = create(vg::makeCommandListRef(parent->cl.m_Context, handle), x, y, width, height);
-    res->parent = parent;
-    if (vg::isValid(handle) && parent != nullptr) {
-        std::shared_ptr<Canvas> orig_parent = parent;
-        while (orig_parent->parent != nullptr)
-            orig_parent = orig_parent->parent;
-        orig_parent->child_.emplace_back(handle);
+    auto cl = vg::makeCommandListRef(parent->cl.m_Context, handle);
+    std::shared_ptr<Canvas> res;
+    if (parent->recording) {
+        // Inside a recorded instance the box is in the instance's own space and
+        // the list replays under whatever scissor the instance is submitted
+        // with, so it narrows that scissor rather than replacing it.
+        res.reset(new Canvas(cl, Rect{x, y, std::max(width, 0.0), std::max(height, 0.0)}));
+        res->recording = true;
+        vg::clIntersectScissor(cl, res->rect.x, res->rect.y, res->rect.w, res->rect.h);
+    } else {
+        // The list is submitted under the parent's scissor, which can clip
+        // tighter than its own box and is set again only when it doesn't.
+        auto box = pixelBox(x, y, width, height);
+        res.reset(new Canvas(cl, box));
+        res->scissor = parent->scissor;
+        if (!box.contains(parent->scissor)) {
+            res->scissor = box & parent->scissor;
+            if (!res->scissor.valid())
+                res->scissor = Rect::Empty;
+            vg::clSetScissor(cl, res->scissor.x, res->scissor.y, res->scissor.w, res->scissor.h);
+        }
     }
+
+    res->root = parent->root;
+    if (vg::isValid(handle))
+        res->root->child_.emplace_back(handle);
     return res;
 }
 
@@ -36,22 +85,211 @@ std::shared_ptr<Canvas> Canvas::create(std::shared_ptr<Canvas> parent, const Rec
     return create(parent, box.x, box.y, box.w, box.h);
 }
 
-Canvas::Canvas(vg::CommandListRef cl, int x, int y, int width, int height)
+std::shared_ptr<Canvas> Canvas::findInstance(const void* key) const
+{
+    auto it = root->instances_.find(key);
+    if (it == root->instances_.end())
+        return nullptr;
+    return it->second;
+}
+
+std::shared_ptr<Canvas> Canvas::createInstance(const void* key, const Rect& box)
+{
+    // The recording is replayed by submit() under each instance's transform,
+    // so it sets no scissor of its own and inherits the submitter's.
+    auto handle = vg::createCommandList(cl.m_Context, vg::CommandListFlags::Cacheable);
+    auto res = std::shared_ptr<Canvas>(new Canvas(vg::makeCommandListRef(cl.m_Context, handle), box));
+    res->root = root;
+    res->recording = true;
+    if (vg::isValid(handle))
+        root->child_.emplace_back(handle);
+    root->instances_.emplace(key, res);
+    return res;
+}
+
+std::shared_ptr<Canvas> Canvas::findClip(const void* key, const Transform& transform, const Rect& box) const
+{
+    auto it = root->clips_.find(key);
+    if (it == root->clips_.end())
+        return nullptr;
+
+    const auto& a = it->second.first;
+    const auto& b = transform;
+    if (a.m00 != b.m00 || a.m10 != b.m10 || a.m01 != b.m01 || a.m11 != b.m11 || a.m02 != b.m02 || a.m12 != b.m12)
+        return nullptr;
+    if (!it->second.second->box().contains(box))
+        return nullptr;
+    return it->second.second;
+}
+
+std::shared_ptr<Canvas> Canvas::createClip(const void* key, const Transform& transform, const Rect& bounds, const Rect& box)
+{
+    // The mask covers the clip's bounds within the root canvas, so later
+    // objects under the same clip and transform can reuse it. Content in
+    // another space, such as a pattern tile, only gets the box it asked for.
+    // Each clip keeps its latest mask only: one that changes transform per
+    // object, as objectBoundingBox units do, holds a single surface.
+    auto area = bounds & root->box();
+    if (!area.contains(box))
+        area = box;
+
+    area = pixelBox(area.x, area.y, area.w, area.h);
+    auto surface = plutovg_surface_create(static_cast<int>(area.w), static_cast<int>(area.h));
+    auto res = std::shared_ptr<Canvas>(new Canvas(surface, area));
+    res->root = root;
+    root->clips_[key] = std::make_pair(transform, res);
+    return res;
+}
+
+PackedStops::PackedStops(const GradientStops& stops)
+{
+    colors.reserve(stops.size());
+    offsets.reserve(stops.size());
+    for (auto& stop : stops) {
+        auto& color = stop.second;
+        colors.emplace_back(vg::color4f(color.r, color.g, color.b, color.a));
+        offsets.emplace_back(stop.first);
+    }
+}
+
+Canvas::Canvas(vg::CommandListRef cl, const Rect& rect)
 {
     this->cl = cl;
     paintType = PaintType::COLOR;
     color = vg::Colors::White;
-    rect = { (float)x, (float)y, (float)width, (float)height };
     latestPath = nullptr;
-    vg::clSetScissor(cl, x, y, width, height);
+    root = this;
+    recording = false;
+    this->rect = rect;
+}
+
+Canvas::Canvas(plutovg_surface_t* surface, const Rect& rect)
+{
+    this->surface = surface;
+    this->pluto = plutovg_create(surface);
+    this->translation = Transform::translated(-rect.x, -rect.y);
+    paintType = PaintType::COLOR;
+    latestPath = nullptr;
+    root = this;
+    recording = false;
+    this->rect = rect;
 }
 
 Canvas::~Canvas()
 {
+    if (pluto) {
+        plutovg_destroy(pluto);
+        plutovg_surface_destroy(surface);
+        return;
+    }
+
+    // Lists run only once recording is over, so closing the last state
+    // block here still comes before anything that submits this one.
+    restoreState();
+}
+
+static plutovg_matrix_t to_plutovg_matrix(const Transform& transform)
+{
+    plutovg_matrix_t matrix;
+    plutovg_matrix_init(&matrix, transform.m00, transform.m10, transform.m01, transform.m11, transform.m02, transform.m12);
+    return matrix;
+}
+
+static plutovg_fill_rule_t to_plutovg_fill_rule(WindRule winding)
+{
+    return winding == WindRule::EvenOdd ? plutovg_fill_rule_even_odd : plutovg_fill_rule_non_zero;
+}
+
+static plutovg_operator_t to_plutovg_operator(BlendMode mode)
+{
+    switch (mode) {
+    case BlendMode::Src:
+        return plutovg_operator_src;
+    case BlendMode::Dst_In:
+        return plutovg_operator_dst_in;
+    case BlendMode::Dst_Out:
+        return plutovg_operator_dst_out;
+    default:
+        return plutovg_operator_src_over;
+    }
+}
+
+static plutovg_line_cap_t to_plutovg_line_cap(LineCap cap)
+{
+    switch (cap) {
+    case LineCap::Round:
+        return plutovg_line_cap_round;
+    case LineCap::Square:
+        return plutovg_line_cap_square;
+    default:
+        return plutovg_line_cap_butt;
+    }
+}
+
+static plutovg_line_join_t to_plutovg_line_join(LineJoin join)
+{
+    switch (join) {
+    case LineJoin::Round:
+        return plutovg_line_join_round;
+    case LineJoin::Bevel:
+        return plutovg_line_join_bevel;
+    default:
+        return plutovg_line_join_miter;
+    }
+}
+
+static plutovg_spread_method_t to_plutovg_spread_method(SpreadMethod spread)
+{
+    switch (spread) {
+    case SpreadMethod::Reflect:
+        return plutovg_spread_method_reflect;
+    case SpreadMethod::Repeat:
+        return plutovg_spread_method_repeat;
+    default:
+        return plutovg_spread_method_pad;
+    }
+}
+
+static void to_plutovg_stops(plutovg_gradient_t* gradient, const GradientStops& stops)
+{
+    for (auto& stop : stops) {
+        auto& color = stop.second;
+        plutovg_gradient_add_stop_rgba(gradient, stop.first, color.r, color.g, color.b, color.a);
+    }
+}
+
+static void to_plutovg_path(plutovg_t* pluto, const Path& path)
+{
+    PathIterator it(path);
+    std::array<Point, 3> p;
+    while (!it.isDone())
+    {
+        switch (it.currentSegment(p)) {
+        case PathCommand::MoveTo:
+            plutovg_move_to(pluto, p[0].x, p[0].y);
+            break;
+        case PathCommand::LineTo:
+            plutovg_line_to(pluto, p[0].x, p[0].y);
+            break;
+        case PathCommand::CubicTo:
+            plutovg_cubic_to(pluto, p[0].x, p[0].y, p[1].x, p[1].y, p[2].x, p[2].y);
+            break;
+        case PathCommand::Close:
+            plutovg_close_path(pluto);
+            break;
+        }
+
+        it.next();
+    }
 }
 
 void Canvas::setColor(const Color& color)
 {
+    if (pluto) {
+        plutovg_set_source_rgba(pluto, color.r, color.g, color.b, color.a);
+        return;
+    }
+
     this->paintType = PaintType::COLOR;
     this->color = vg::color4f(
         color.r,
@@ -61,9 +299,19 @@ void Canvas::setColor(const Color& color)
     );
 }
 
-void Canvas::setLinearGradient(double x1, double y1, double x2, double y2, const GradientStops& stops, SpreadMethod spread, const Transform& transform)
+void Canvas::setLinearGradient(double x1, double y1, double x2, double y2, const GradientStops& stops, const PackedStops& packed, SpreadMethod spread, const Transform& transform)
 {
-    this->paintType = PaintType::LINEAR_GRADIENT;
+    if (pluto) {
+        auto gradient = plutovg_gradient_create_linear(x1, y1, x2, y2);
+        auto matrix = to_plutovg_matrix(transform);
+        to_plutovg_stops(gradient, stops);
+        plutovg_gradient_set_spread(gradient, to_plutovg_spread_method(spread));
+        plutovg_gradient_set_matrix(gradient, &matrix);
+        plutovg_set_source_gradient(pluto, gradient);
+        plutovg_gradient_destroy(gradient);
+        return;
+    }
+
     auto dx = (float)(x2 - x1);
     auto dy = (float)(y2 - y1);
     float xform[6]{
@@ -80,28 +328,23 @@ void Canvas::setLinearGradient(double x1, double y1, double x2, double y2, const
     float s[2], e[2];
     vgutil::transformPos2D(0.f, 0.f, res, s);
     vgutil::transformPos2D(0.f, 1.f, res, e);
-    this->gradientParams[0] = s[0];
-    this->gradientParams[1] = s[1];
-    this->gradientParams[2] = e[0];
-    this->gradientParams[3] = e[1];
-    this->gradientColors.clear();
-    this->gradientStops.clear();
-    for (auto& stop : stops) {
-        this->gradientStops.emplace_back(stop.first);
-        auto& color = stop.second;
-        this->gradientColors.emplace_back(vg::color4f(color.r, color.g, color.b, color.a));
-    }
+    float params[4]{s[0], s[1], e[0], e[1]};
+    setGradient(PaintType::LINEAR_GRADIENT, params, packed);
 }
 
-void Canvas::setRadialGradient(double cx, double cy, double r, double fx, double fy, const GradientStops& stops, SpreadMethod spread, const Transform& transform)
+void Canvas::setRadialGradient(double cx, double cy, double r, double fx, double fy, const GradientStops& stops, const PackedStops& packed, SpreadMethod spread, const Transform& transform)
 {
-    this->paintType = PaintType::RADIAL_GRADIENT;
-    Color icol, ocol;
-    if (!stops.empty()) {
-        icol = stops[0].second;
-        ocol = stops[stops.size() - 1].second;
-    } else
-        icol = ocol = { 1.f, 1.f, 1.f, 1.f };
+    if (pluto) {
+        auto gradient = plutovg_gradient_create_radial(cx, cy, r, fx, fy, 0);
+        auto matrix = to_plutovg_matrix(transform);
+        to_plutovg_stops(gradient, stops);
+        plutovg_gradient_set_spread(gradient, to_plutovg_spread_method(spread));
+        plutovg_gradient_set_matrix(gradient, &matrix);
+        plutovg_set_source_gradient(pluto, gradient);
+        plutovg_gradient_destroy(gradient);
+        return;
+    }
+
     float xform[6]{
         (float)r, 0,
         0, (float)r,
@@ -116,122 +359,146 @@ void Canvas::setRadialGradient(double cx, double cy, double r, double fx, double
     float s[2], r_[2];
     vgutil::transformPos2D(0.f, 0.f, res, s);
     vgutil::transformPos2D(0.f, 1.f, res, r_);
-    this->gradientParams[0] = s[0];
-    this->gradientParams[1] = s[1];
-    this->gradientParams[2] = 0.f;
-    this->gradientParams[3] = std::max(r_[0], r_[1]) * 2.f;
-    this->gradientColors.clear();
-    this->gradientStops.clear();
-    for (auto& stop : stops) {
-        this->gradientStops.emplace_back(stop.first);
-        auto& color = stop.second;
-        this->gradientColors.emplace_back(vg::color4f(color.r, color.g, color.b, color.a));
-    }
+    float params[4]{s[0], s[1], 0.f, std::max(r_[0], r_[1]) * 2.f};
+    setGradient(PaintType::RADIAL_GRADIENT, params, packed);
+}
+
+void Canvas::setGradient(PaintType type, const float params[4], const PackedStops& packed)
+{
+    // A fill and stroke painted alike, such as one shape's, share the vg
+    // gradient created for the first of them.
+    if (this->paintType != type || this->gradientStops != &packed || !std::equal(params, params + 4, this->gradientParams))
+        this->gradientValid = false;
+
+    this->paintType = type;
+    std::copy(params, params + 4, this->gradientParams);
+    this->gradientStops = &packed;
 }
 
 void Canvas::setTexture(const Canvas* source, TextureType type, const Transform& transform)
 {
+    if (pluto) {
+        auto texture = plutovg_texture_create(source->surface);
+        auto matrix = to_plutovg_matrix(transform);
+        plutovg_texture_set_type(texture, type == TextureType::Plain ? plutovg_texture_type_plain : plutovg_texture_type_tiled);
+        plutovg_texture_set_matrix(texture, &matrix);
+        plutovg_set_source_texture(pluto, texture);
+        plutovg_texture_destroy(texture);
+        return;
+    }
+
     // TODO
     this->paintType = PaintType::COLOR;
     this->color = vg::Colors::White;
 }
 
-void pathToVG(vg::CommandListRef cl, const Path& path) {
+void pathToVG(vg::CommandListRef cl, const Path& path, const ShapeInfo& info) {
+    // Layout gives shapes their info, floats included; other paths get it here.
+    if (info.kind == ShapeKind::Path && info.coords.size() != path.points().size() * 2) {
+        pathToVG(cl, path, ShapeInfo(path));
+        return;
+    }
+
     vg::clBeginPath(cl);
-    PathIterator it(path);
-    std::array<Point, 3> p;
-    while (!it.isDone())
-    {
-        switch (it.currentSegment(p)) {
+    const auto& box = info.box;
+    switch (info.kind) {
+    case ShapeKind::Rect:
+        vg::clRect(cl, box.x, box.y, box.w, box.h);
+        return;
+    case ShapeKind::RoundedRect:
+        vg::clRoundedRect(cl, box.x, box.y, box.w, box.h, info.rx);
+        return;
+    case ShapeKind::Ellipse:
+        if (info.rx == info.ry)
+            vg::clCircle(cl, box.x + info.rx, box.y + info.ry, info.rx);
+        else
+            vg::clEllipse(cl, box.x + info.rx, box.y + info.ry, info.rx, info.ry);
+        return;
+    default:
+        break;
+    }
+
+    auto p = info.coords.data();
+    for (auto command : path.commands()) {
+        switch (command) {
         case PathCommand::MoveTo:
-            vg::clMoveTo(cl, p[0].x, p[0].y);
+            vg::clMoveTo(cl, p[0], p[1]);
+            p += 2;
             break;
         case PathCommand::LineTo:
-            vg::clLineTo(cl, p[0].x, p[0].y);
+            vg::clLineTo(cl, p[0], p[1]);
+            p += 2;
             break;
         case PathCommand::CubicTo:
-            vg::clCubicTo(cl, p[0].x, p[0].y, p[1].x, p[1].y, p[2].x, p[2].y);
+            vg::clCubicTo(cl, p[0], p[1], p[2], p[3], p[4], p[5]);
+            p += 6;
             break;
         case PathCommand::Close:
             vg::clClosePath(cl);
             break;
         }
-
-        it.next();
     }
 }
 
-void Canvas::fill(const Path& path, const Transform& transform, WindRule winding, BlendMode mode, double opacity)
+void Canvas::fill(const Path& path, const ShapeInfo& info, const Transform& transform, WindRule winding, BlendMode mode, double opacity)
 {
-    vg::clPushState(this->cl);
+    if (pluto) {
+        auto matrix = to_plutovg_matrix(transform * translation);
+        to_plutovg_path(pluto, path);
+        plutovg_set_matrix(pluto, &matrix);
+        plutovg_set_fill_rule(pluto, to_plutovg_fill_rule(winding));
+        plutovg_set_opacity(pluto, opacity);
+        plutovg_set_operator(pluto, to_plutovg_operator(mode));
+        plutovg_fill(pluto);
+        return;
+    }
+
     float transform_[6]{
         (float)transform.m00, (float)transform.m10, (float)transform.m01,
         (float)transform.m11, (float)transform.m02, (float)transform.m12,
     };
-    vg::clTransformMult(this->cl, transform_, vg::TransformOrder::Post);
-    if (this->latestPath != &path) {
+    setState(transform_, (float)opacity);
+    if (this->latestPath != &path || !std::equal(transform_, transform_ + 6, this->latestTransform)) {
         this->latestPath = &path;
-        pathToVG(cl, path);
+        std::copy(transform_, transform_ + 6, this->latestTransform);
+        pathToVG(cl, path, info);
     }
     static_assert((uint32_t)WindRule::EvenOdd == (uint32_t)vg::FillRule::EvenOdd);
     static_assert((uint32_t)WindRule::NonZero == (uint32_t)vg::FillRule::NonZero);
-    auto flags = VG_FILL_FLAGS(vg::PathType::Concave, (uint32_t)winding, true);
-    switch (this->paintType) {
-        default:
-        case PaintType::COLOR:
-            vg::clFillPath(
-                this->cl,
-                this->color,
-                flags
-            );
-            break;
-        case PaintType::LINEAR_GRADIENT:
-            vg::clFillPath(
-                this->cl,
-                vg::clCreateLinearGradient(
-                    this->cl,
-                    this->gradientParams[0],
-                    this->gradientParams[1],
-                    this->gradientParams[2],
-                    this->gradientParams[3],
-                    this->gradientColors.data(),
-                    this->gradientStops.data(),
-                    (uint16_t)this->gradientStops.size()
-                ),
-                flags
-            );
-            break;
-        case PaintType::RADIAL_GRADIENT:
-            vg::clFillPath(
-                this->cl,
-                vg::clCreateRadialGradient(
-                    this->cl,
-                    this->gradientParams[0],
-                    this->gradientParams[1],
-                    this->gradientParams[2],
-                    this->gradientParams[3],
-                    this->gradientColors.data(),
-                    this->gradientStops.data(),
-                    (uint16_t)this->gradientStops.size()
-                ),
-                flags
-            );
-            break;
-    }
-    vg::clPopState(this->cl);
+    auto type = info.convex ? vg::PathType::Convex : vg::PathType::Concave;
+    auto flags = VG_FILL_FLAGS(type, (uint32_t)winding, true);
+    if (this->paintType == PaintType::COLOR)
+        vg::clFillPath(this->cl, this->color, flags);
+    else
+        vg::clFillPath(this->cl, gradient(), flags);
 }
 
-void Canvas::stroke(const Path& path, const Transform& transform, double width, LineCap cap, LineJoin join, double miterlimit, const DashData& dash, BlendMode mode, double opacity)
+void Canvas::stroke(const Path& path, const ShapeInfo& info, const Transform& transform, double width, LineCap cap, LineJoin join, double miterlimit, const DashData& dash, BlendMode mode, double opacity)
 {
-    vg::clPushState(this->cl);
+    if (pluto) {
+        auto matrix = to_plutovg_matrix(transform * translation);
+        to_plutovg_path(pluto, path);
+        plutovg_set_matrix(pluto, &matrix);
+        plutovg_set_line_width(pluto, width);
+        plutovg_set_line_cap(pluto, to_plutovg_line_cap(cap));
+        plutovg_set_line_join(pluto, to_plutovg_line_join(join));
+        plutovg_set_miter_limit(pluto, miterlimit);
+        plutovg_set_dash(pluto, dash.offset, dash.array.data(), static_cast<int>(dash.array.size()));
+        plutovg_set_operator(pluto, to_plutovg_operator(mode));
+        plutovg_set_opacity(pluto, opacity);
+        plutovg_stroke(pluto);
+        return;
+    }
+
     float transform_[6]{
         (float)transform.m00, (float)transform.m10, (float)transform.m01,
         (float)transform.m11, (float)transform.m02, (float)transform.m12,
     };
-    vg::clTransformMult(this->cl, transform_, vg::TransformOrder::Post);
-    if (this->latestPath != &path) {
+    setState(transform_, (float)opacity);
+    if (this->latestPath != &path || !std::equal(transform_, transform_ + 6, this->latestTransform)) {
         this->latestPath = &path;
-        pathToVG(cl, path);
+        std::copy(transform_, transform_ + 6, this->latestTransform);
+        pathToVG(cl, path, info);
     }
     static_assert((uint32_t)LineJoin::Bevel == (uint32_t)vg::LineJoin::Bevel);
     static_assert((uint32_t)LineJoin::Miter == (uint32_t)vg::LineJoin::Miter);
@@ -240,66 +507,104 @@ void Canvas::stroke(const Path& path, const Transform& transform, double width,
     static_assert((uint32_t)LineCap::Round == (uint32_t)vg::LineCap::Round);
     static_assert((uint32_t)LineCap::Square == (uint32_t)vg::LineCap::Square);
     auto flags = VG_STROKE_FLAGS((uint32_t)cap, (uint32_t)join, true);
-    switch (this->paintType) {
-        default:
-        case PaintType::COLOR:
-            vg::clStrokePath(
-                this->cl,
-                this->color,
-                width,
-                flags
-            );
-            break;
-        case PaintType::LINEAR_GRADIENT:
-            vg::clStrokePath(
-                this->cl,
-                vg::clCreateLinearGradient(
-                    this->cl,
-                    this->gradientParams[0],
-                    this->gradientParams[1],
-                    this->gradientParams[2],
-                    this->gradientParams[3],
-                    this->gradientColors.data(),
-                    this->gradientStops.data(),
-                    (uint16_t)this->gradientStops.size()
-                ),
-                width,
-                flags
-            );
-            break;
-        case PaintType::RADIAL_GRADIENT:
-            vg::clStrokePath(
-                this->cl,
-                vg::clCreateRadialGradient(
-                    this->cl,
-                    this->gradientParams[0],
-                    this->gradientParams[1],
-                    this->gradientParams[2],
-                    this->gradientParams[3],
-                    this->gradientColors.data(),
-                    this->gradientStops.data(),
-                    (uint16_t)this->gradientStops.size()
-                ),
-                width,
-                flags
-            );
-            break;
+    if (this->paintType == PaintType::COLOR)
+        vg::clStrokePath(this->cl, this->color, width, flags);
+    else
+        vg::clStrokePath(this->cl, gradient(), width, flags);
+}
+
+// Draws leave their transform and opacity pushed, so the draws that follow
+// under the same state, such as a shape's fill, stroke and markers, share one
+// push and pop. Anything that needs the list's own state pops it first.
+void Canvas::setState(const float transform[6], float opacity)
+{
+    if (this->statePushed) {
+        if (opacity == this->stateOpacity && std::equal(transform, transform + 6, this->stateTransform))
+            return;
+        vg::clPopState(this->cl);
     }
+
+    vg::clPushState(this->cl);
+    vg::clTransformMult(this->cl, transform, vg::TransformOrder::Post);
+    if (opacity < 1.f)
+        vg::clMulColor(this->cl, vg::color4f(1.f, 1.f, 1.f, opacity));
+    std::copy(transform, transform + 6, this->stateTransform);
+    this->stateOpacity = opacity;
+    this->statePushed = true;
+    // vg places a gradient under the transform current when it is created.
+    this->gradientValid = false;
+}
+
+void Canvas::restoreState()
+{
+    if (!this->statePushed)
+        return;
+
     vg::clPopState(this->cl);
+    this->statePushed = false;
+    this->gradientValid = false;
+}
+
+vg::GradientHandle Canvas::gradient()
+{
+    if (this->gradientValid)
+        return this->gradientHandle;
+
+    const auto& params = this->gradientParams;
+    const auto& stops = *this->gradientStops;
+    auto count = (uint16_t)stops.offsets.size();
+    if (this->paintType == PaintType::LINEAR_GRADIENT)
+        this->gradientHandle = vg::clCreateLinearGradient(this->cl, params[0], params[1], params[2], params[3], stops.colors.data(), stops.offsets.data(), count);
+    else
+        this->gradientHandle = vg::clCreateRadialGradient(this->cl, params[0], params[1], params[2], params[3], stops.colors.data(), stops.offsets.data(), count);
+    this->gradientValid = true;
+    return this->gradientHandle;
 }
 
 void Canvas::blend(const Canvas* source, BlendMode mode, double opacity)
 {
+    if (pluto) {
+        auto matrix = to_plutovg_matrix(translation);
+        plutovg_set_source_surface(pluto, source->surface, source->rect.x, source->rect.y);
+        plutovg_set_operator(pluto, to_plutovg_operator(mode));
+        plutovg_set_opacity(pluto, opacity);
+        plutovg_set_matrix(pluto, &matrix);
+        plutovg_paint(pluto);
+        return;
+    }
+
+    restoreState();
+    vg::clPushState(this->cl);
+    if (opacity < 1.0)
+        vg::clMulColor(this->cl, vg::color4f(1.f, 1.f, 1.f, (float)opacity));
+    vg::clSubmitCommandList(this->cl, source->cl.m_Handle);
+    vg::clPopState(this->cl);
+}
+
+void Canvas::submit(const Canvas* source, const Transform& transform, double opacity)
+{
+    restoreState();
     vg::clPushState(this->cl);
-    vg::clMulColor(this->cl, vg::color4f(1.f, 1.f, 1.f, (float)opacity));
+    float transform_[6]{
+        (float)transform.m00, (float)transform.m10, (float)transform.m01,
+        (float)transform.m11, (float)transform.m02, (float)transform.m12,
+    };
+    vg::clTransformMult(this->cl, transform_, vg::TransformOrder::Post);
+    if (opacity < 1.0)
+        vg::clMulColor(this->cl, vg::color4f(1.f, 1.f, 1.f, (float)opacity));
     vg::clSubmitCommandList(this->cl, source->cl.m_Handle);
     vg::clPopState(this->cl);
+    // The replayed list leaves its own path behind.
+    this->latestPath = nullptr;
 }
 
 void Canvas::mask(const Rect& clip, const Transform& transform)
 {
-    // TODO
-    /*auto matrix = to_plutovg_matrix(transform);
+    // TODO: vg
+    if (!pluto)
+        return;
+
+    auto matrix = to_plutovg_matrix(transform);
     auto path = plutovg_path_create();
     plutovg_path_add_rect(path, clip.x, clip.y, clip.w, clip.h);
     plutovg_path_transform(path, &matrix);
@@ -307,18 +612,68 @@ void Canvas::mask(const Rect& clip, const Transform& transform)
     plutovg_add_path(pluto, path);
     plutovg_path_destroy(path);
 
+    auto translation_ = to_plutovg_matrix(translation);
     plutovg_set_source_rgba(pluto, 0, 0, 0, 0);
     plutovg_set_fill_rule(pluto, plutovg_fill_rule_even_odd);
     plutovg_set_operator(pluto, plutovg_operator_src);
     plutovg_set_opacity(pluto, 0.0);
-    plutovg_set_matrix(pluto, &translation);
-    plutovg_fill(pluto);*/
+    plutovg_set_matrix(pluto, &translation_);
+    plutovg_fill(pluto);
+}
+
+// Clips what follows to a device rectangle until popClip. Command lists take
+// it as a scissor, which can only keep whole pixels, so its edges round to
+// the nearest pixel; raster canvases clip with antialiased edges.
+void Canvas::pushClip(const Rect& clip)
+{
+    if (pluto) {
+        auto matrix = to_plutovg_matrix(translation);
+        plutovg_save(pluto);
+        plutovg_set_matrix(pluto, &matrix);
+        plutovg_rect(pluto, clip.x, clip.y, clip.w, clip.h);
+        plutovg_clip(pluto);
+        return;
+    }
+
+    restoreState();
+    vg::clPushState(this->cl);
+    this->scissors_.push_back(this->scissor);
+    if (this->recording) {
+        // Recorded boxes are in the instance's space, see create().
+        vg::clIntersectScissor(this->cl, clip.x, clip.y, clip.w, clip.h);
+        return;
+    }
+
+    auto l = std::round(clip.x);
+    auto t = std::round(clip.y);
+    auto r = std::round(clip.x + clip.w);
+    auto b = std::round(clip.y + clip.h);
+    this->scissor = Rect{l, t, r - l, b - t} & this->scissor;
+    if (!this->scissor.valid())
+        this->scissor = Rect::Empty;
+    vg::clSetScissor(this->cl, this->scissor.x, this->scissor.y, this->scissor.w, this->scissor.h);
+}
+
+void Canvas::popClip()
+{
+    if (pluto) {
+        plutovg_restore(pluto);
+        return;
+    }
+
+    restoreState();
+    vg::clPopState(this->cl);
+    this->scissor = this->scissors_.back();
+    this->scissors_.pop_back();
 }
 
 void Canvas::rgba()
 {
-    // TODO
-    /*auto width = plutovg_surface_get_width(surface);
+    // TODO: vg
+    if (!pluto)
+        return;
+
+    auto width = plutovg_surface_get_width(surface);
     auto height = plutovg_surface_get_height(surface);
     auto stride = plutovg_surface_get_stride(surface);
     auto data = plutovg_surface_get_data(surface);
@@ -344,13 +699,16 @@ void Canvas::rgba()
 
             pixels[x] = (a << 24) | (b << 16) | (g << 8) | r;
         }
-    }*/
+    }
 }
 
 void Canvas::luminance()
 {
-    // TODO
-    /*auto width = plutovg_surface_get_width(surface);
+    // TODO: vg
+    if (!pluto)
+        return;
+
+    auto width = plutovg_surface_get_width(surface);
     auto height = plutovg_surface_get_height(surface);
     auto stride = plutovg_surface_get_stride(surface);
     auto data = plutovg_surface_get_data(surface);
@@ -367,7 +725,18 @@ void Canvas::luminance()
 
             pixels[x] = l << 24;
         }
-    }*/
+    }
+}
+
+bool Canvas::isOutside(const Rect& box) const
+{
+    // Command lists keep everything. A raster canvas only has pixels inside
+    // its box, widened by one pixel for antialiasing.
+    if (!pluto || !box.valid())
+        return false;
+
+    return box.x + box.w + 1.0 <= rect.x || box.x - 1.0 >= rect.x + rect.w
+        || box.y + box.h + 1.0 <= rect.y || box.y - 1.0 >= rect.y + rect.h;
 }
 
 unsigned int Canvas::width() const
@@ -4,13 +4,30 @@
 #include "property.h"
 #include <vg/vg.h>
 
+#include <map>
 #include <memory>
 
+typedef struct plutovg_surface plutovg_surface_t;
+typedef struct plutovg plutovg_t;
+
 namespace lunasvg {
 
 using GradientStop = std::pair<double, Color>;
 using GradientStops = std::vector<GradientStop>;
 
+// Gradient stops packed into the color and offset arrays the vg backend
+// records, built once at layout.
+class PackedStops
+{
+public:
+    PackedStops() = default;
+    explicit PackedStops(const GradientStops& stops);
+
+public:
+    std::vector<vg::Color> colors;
+    std::vector<float> offsets;
+};
+
 using DashArray = std::vector<double>;
 
 struct DashData
@@ -33,24 +50,30 @@ enum class BlendMode
     Dst_Out
 };
 
-class CanvasImpl;
-
+// A canvas either records vg command lists or, when created over pixel
+// memory, rasterizes on the CPU through plutovg. Canvases created from a
+// parent use the parent's backend.
 class Canvas
 {
 public:
     static std::shared_ptr<Canvas> create(vg::CommandListRef cl, double x, double y, double width, double height);
+    static std::shared_ptr<Canvas> create(unsigned char* data, unsigned int width, unsigned int height, unsigned int stride);
+    static std::shared_ptr<Canvas> create(unsigned char* data, int x, int y, unsigned int width, unsigned int height, unsigned int stride);
     static std::shared_ptr<Canvas> create(std::shared_ptr<Canvas> parent, double x, double y, double width, double height);
     static std::shared_ptr<Canvas> create(std::shared_ptr<Canvas> parent, const Rect& box);
 
     void setColor(const Color& color);
-    void setLinearGradient(double x1, double y1, double x2, double y2, const GradientStops& stops, SpreadMethod spread, const Transform& transform);
-    void setRadialGradient(double cx, double cy, double r, double fx, double fy, const GradientStops& stops, SpreadMethod spread, const Transform& transform);
+    void setLinearGradient(double x1, double y1, double x2, double y2, const GradientStops& stops, const PackedStops& packed, SpreadMethod spread, const Transform& transform);
+    void setRadialGradient(double cx, double cy, double r, double fx, double fy, const GradientStops& stops, const PackedStops& packed, SpreadMethod spread, const Transform& transform);
     void setTexture(const Canvas* source, TextureType type, const Transform& transform);
 
-    void fill(const Path& path, const Transform& transform, WindRule winding, BlendMode mode, double opacity);
-    void stroke(const Path& path, const Transform& transform, double width, LineCap cap, LineJoin join, double miterlimit, const DashData& dash, BlendMode mode, double opacity);
+    void fill(const Path& path, const ShapeInfo& info, const Transform& transform, WindRule winding, BlendMode mode, double opacity);
+    void stroke(const Path& path, const ShapeInfo& info, const Transform& transform, double width, LineCap cap, LineJoin join, double miterlimit, const DashData& dash, BlendMode mode, double opacity);
     void blend(const Canvas* source, BlendMode mode, double opacity);
+    void submit(const Canvas* source, const Transform& transform, double opacity);
     void mask(const Rect& clip, const Transform& transform);
+    void pushClip(const Rect& clip);
+    void popClip();
 
     void rgba();
     void luminance();
@@ -59,27 +82,60 @@ public:
     unsigned int height() const;
     Rect box() const;
     const std::vector<vg::CommandListHandle>& child() const { return this->child_; }
+    bool isRaster() const { return this->pluto != nullptr; }
+    bool isOutside(const Rect& box) const;
+
+    void elideLayer() { ++this->root->elidedLayers_; }
+    std::size_t elidedLayers() const { return this->root->elidedLayers_; }
+
+    std::shared_ptr<Canvas> findInstance(const void* key) const;
+    std::shared_ptr<Canvas> createInstance(const void* key, const Rect& box);
+
+    std::shared_ptr<Canvas> findClip(const void* key, const Transform& transform, const Rect& box) const;
+    std::shared_ptr<Canvas> createClip(const void* key, const Transform& transform, const Rect& bounds, const Rect& box);
 
     ~Canvas();
 private:
-    Canvas(vg::CommandListRef cl, int x, int y, int width, int height);
+    Canvas(vg::CommandListRef cl, const Rect& rect);
+    Canvas(plutovg_surface_t* surface, const Rect& rect);
 
     enum class PaintType : uint8_t {
         COLOR,
         LINEAR_GRADIENT,
         RADIAL_GRADIENT,
     };
+
+    void setGradient(PaintType type, const float params[4], const PackedStops& packed);
+    void setState(const float transform[6], float opacity);
+    void restoreState();
+    vg::GradientHandle gradient();
+
     PaintType paintType;
     vg::Color color;
     float gradientParams[4];
-    std::vector<vg::Color> gradientColors;
-    std::vector<float> gradientStops;
+    const PackedStops* gradientStops{nullptr};
+    vg::GradientHandle gradientHandle;
+    bool gradientValid{false};
     const Path* latestPath;
+    float latestTransform[6];
+    bool statePushed{false};
+    float stateTransform[6];
+    float stateOpacity;
 
     vg::CommandListRef cl;
     std::vector<vg::CommandListHandle> child_;
-    std::shared_ptr<Canvas> parent;
+    std::map<const void*, std::shared_ptr<Canvas>> instances_;
+    std::map<const void*, std::pair<Transform, std::shared_ptr<Canvas>>> clips_;
+    std::size_t elidedLayers_{0};
+    std::vector<Rect> scissors_;
+    Canvas* root;
+    bool recording;
     Rect rect;
+    Rect scissor;
+
+    plutovg_surface_t* surface{nullptr};
+    plutovg_t* pluto{nullptr};
+    Transform translation;
 };
 
 } // namespace lunasvg
@@ -11,27 +11,40 @@ ClipPathElement::ClipPathElement()
 
 Units ClipPathElement::clipPathUnits() const
 {
-    auto& value = get(PropertyId::ClipPathUnits);
-    return Parser::parseUnits(value, Units::UserSpaceOnUse);
+    return getParsed(PropertyId::ClipPathUnits, [](const std::string& value) {
+        return Parser::parseUnits(value, Units::UserSpaceOnUse);
+    });
 }
 
-std::unique_ptr<LayoutClipPath> ClipPathElement::getClipper(LayoutContext* context) const
+LayoutClipPath* ClipPathElement::getClipper(LayoutContext* context) const
 {
     if(context->hasReference(this))
         return nullptr;
 
     LayoutBreaker layoutBreaker(context, this);
-    auto clipper = std::make_unique<LayoutClipPath>();
+    auto clipper = context->create<LayoutClipPath>();
     clipper->units = clipPathUnits();
     clipper->transform = transform();
     clipper->clipper = context->getClipper(clip_path());
-    layoutChildren(context, clipper.get());
+    layoutChildren(context, clipper);
+
+    // A clip that is one axis-aligned rectangle keeps it, in its own units,
+    // so that it can be drawn as a scissor.
+    const auto& children = clipper->children;
+    if(!clipper->clipper && !children.empty() && *children.begin() == children.back() && children.back()->id == LayoutId::Shape)
+    {
+        auto shape = static_cast<const LayoutShape*>(children.back());
+        const auto& m = shape->transform;
+        if(shape->shapeInfo.kind == ShapeKind::Rect && shape->visibility == Visibility::Visible && !shape->clipper && m.m10 == 0.0 && m.m01 == 0.0)
+            clipper->rect = m.map(shape->shapeInfo.box);
+    }
+
     return clipper;
 }
 
-std::unique_ptr<Node> ClipPathElement::clone() const
+Node* ClipPathElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<ClipPathElement>();
+    return cloneElement<ClipPathElement>(arena);
 }
 
 } // namespace lunasvg
@@ -13,9 +13,9 @@ public:
     ClipPathElement();
 
     Units clipPathUnits() const;
-    std::unique_ptr<LayoutClipPath> getClipper(LayoutContext* context) const;
+    LayoutClipPath* getClipper(LayoutContext* context) const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 } // namespace lunasvg
@@ -7,9 +7,9 @@ DefsElement::DefsElement()
 {
 }
 
-std::unique_ptr<Node> DefsElement::clone() const
+Node* DefsElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<DefsElement>();
+    return cloneElement<DefsElement>(arena);
 }
 
 } // namespace lunasvg
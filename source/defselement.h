@@ -10,7 +10,7 @@ class DefsElement : public GraphicsElement
 public:
     DefsElement();
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 } // namespace lunasvg
@@ -19,6 +19,10 @@ void PropertyList::set(PropertyId id, const std::string& value, int specificity)
 
     property->specificity = specificity;
     property->value = value;
+
+    std::size_t index = property - m_properties.data();
+    if(index < m_values.size())
+        m_values[index].reset();
 }
 
 Property* PropertyList::get(PropertyId id) const
@@ -52,11 +56,11 @@ void Node::layout(LayoutContext*, LayoutContainer*) const
 {
 }
 
-std::unique_ptr<Node> TextNode::clone() const
+Node* TextNode::clone(MemoryArena* arena) const
 {
-    auto node = std::make_unique<TextNode>();
+    auto node = arena->create<TextNode>();
     node->text = text;
-    return std::move(node);
+    return node;
 }
 
 Element::Element(ElementId id)
@@ -83,16 +87,30 @@ const std::string& Element::get(PropertyId id) const
 static const std::string InheritString{"inherit"};
 
 const std::string& Element::find(PropertyId id) const
+{
+    auto property = findProperty(id);
+    if(property == nullptr)
+        return EmptyString;
+
+    return property->value;
+}
+
+const Property* Element::findProperty(PropertyId id, const Element** owner) const
 {
     auto element = this;
     do {
-        auto& value = element->get(id);
-        if(!value.empty() && value != InheritString)
-            return value;
+        auto property = element->properties.get(id);
+        if(property && !property->value.empty() && property->value != InheritString)
+        {
+            if(owner)
+                *owner = element;
+            return property;
+        }
+
         element = element->parent;
     } while(element);
 
-    return EmptyString;
+    return nullptr;
 }
 
 bool Element::has(PropertyId id) const
@@ -105,18 +123,12 @@ Element* Element::previousSibling() const
     if(parent == nullptr)
         return nullptr;
 
-    Element* element = nullptr;
-    auto it = parent->children.begin();
-    auto end = parent->children.end();
-    for(;it != end;++it)
+    auto& children = parent->children;
+    for(auto i = index;i > 0;--i)
     {
-        auto node = it->get();
-        if(node->isText())
-            continue;
-
-        if(node == this)
-            return element;
-        element = static_cast<Element*>(node);
+        auto node = children[i - 1];
+        if(!node->isText())
+            return static_cast<Element*>(node);
     }
 
     return nullptr;
@@ -127,28 +139,23 @@ Element* Element::nextSibling() const
     if(parent == nullptr)
         return nullptr;
 
-    Element* element = nullptr;
-    auto it = parent->children.rbegin();
-    auto end = parent->children.rend();
-    for(;it != end;++it)
+    auto& children = parent->children;
+    for(auto i = index + 1;i < children.size();++i)
     {
-        auto node = it->get();
-        if(node->isText())
-            continue;
-
-        if(node == this)
-            return element;
-        element = static_cast<Element*>(node);
+        auto node = children[i];
+        if(!node->isText())
+            return static_cast<Element*>(node);
     }
 
     return nullptr;
 }
 
-Node* Element::addChild(std::unique_ptr<Node> child)
+Node* Element::addChild(Node* child)
 {
     child->parent = this;
-    children.push_back(std::move(child));
-    return &*children.back();
+    child->index = children.size();
+    children.push_back(child);
+    return child;
 }
 
 void Element::layoutChildren(LayoutContext* context, LayoutContainer* current) const
@@ -157,6 +164,143 @@ void Element::layoutChildren(LayoutContext* context, LayoutContainer* current) c
         child->layout(context, current);
 }
 
+static bool usesCurrentColor(const std::string& value)
+{
+    return value.find("currentColor") != std::string::npos;
+}
+
+bool isInheritedProperty(PropertyId id)
+{
+    switch(id) {
+    case PropertyId::Fill:
+    case PropertyId::Stroke:
+    case PropertyId::Color:
+    case PropertyId::Fill_Opacity:
+    case PropertyId::Stroke_Opacity:
+    case PropertyId::Stroke_Miterlimit:
+    case PropertyId::Stroke_Width:
+    case PropertyId::Stroke_Dashoffset:
+    case PropertyId::Stroke_Dasharray:
+    case PropertyId::Fill_Rule:
+    case PropertyId::Clip_Rule:
+    case PropertyId::Stroke_Linecap:
+    case PropertyId::Stroke_Linejoin:
+    case PropertyId::Visibility:
+    case PropertyId::Marker_Start:
+    case PropertyId::Marker_Mid:
+    case PropertyId::Marker_End:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void applyStyle(ComputedStyle& style, PropertyId id, const std::string& value)
+{
+    switch(id) {
+    case PropertyId::Fill:
+        style.fillCurrentColor = usesCurrentColor(value);
+        style.fill = style.fillCurrentColor ? Paint{} : Parser::parsePaint(value, nullptr, Color::Black);
+        break;
+    case PropertyId::Stroke:
+        style.strokeCurrentColor = usesCurrentColor(value);
+        style.stroke = style.strokeCurrentColor ? Paint{} : Parser::parsePaint(value, nullptr, Color::Transparent);
+        break;
+    case PropertyId::Color:
+        // currentColor on color itself means the inherited color.
+        if(!usesCurrentColor(value))
+            style.color = Parser::parseColor(value, nullptr, Color::Black);
+        break;
+    case PropertyId::Fill_Opacity:
+        style.fill_opacity = Parser::parseNumberPercentage(value, 1.0);
+        break;
+    case PropertyId::Stroke_Opacity:
+        style.stroke_opacity = Parser::parseNumberPercentage(value, 1.0);
+        break;
+    case PropertyId::Stroke_Miterlimit:
+        style.stroke_miterlimit = Parser::parseNumber(value, 4.0);
+        break;
+    case PropertyId::Stroke_Width:
+        style.stroke_width = Parser::parseLength(value, ForbidNegativeLengths, Length::One);
+        break;
+    case PropertyId::Stroke_Dashoffset:
+        style.stroke_dashoffset = Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+        break;
+    case PropertyId::Stroke_Dasharray:
+        style.stroke_dasharray = Parser::parseLengthList(value, ForbidNegativeLengths);
+        break;
+    case PropertyId::Fill_Rule:
+        style.fill_rule = Parser::parseWindRule(value);
+        break;
+    case PropertyId::Clip_Rule:
+        style.clip_rule = Parser::parseWindRule(value);
+        break;
+    case PropertyId::Stroke_Linecap:
+        style.stroke_linecap = Parser::parseLineCap(value);
+        break;
+    case PropertyId::Stroke_Linejoin:
+        style.stroke_linejoin = Parser::parseLineJoin(value);
+        break;
+    case PropertyId::Visibility:
+        style.visibility = Parser::parseVisibility(value);
+        break;
+    case PropertyId::Marker_Start:
+        style.marker_start = Parser::parseUrl(value);
+        break;
+    case PropertyId::Marker_Mid:
+        style.marker_mid = Parser::parseUrl(value);
+        break;
+    case PropertyId::Marker_End:
+        style.marker_end = Parser::parseUrl(value);
+        break;
+    default:
+        break;
+    }
+}
+
+static const std::shared_ptr<const ComputedStyle>& initialStyle()
+{
+    static const std::shared_ptr<const ComputedStyle> style = [] {
+        // An empty value parses to the initial value of each property.
+        auto style = std::make_shared<ComputedStyle>();
+        for(int id = 0;id <= static_cast<int>(PropertyId::Y2);++id)
+        {
+            if(isInheritedProperty(static_cast<PropertyId>(id)))
+                applyStyle(*style, static_cast<PropertyId>(id), EmptyString);
+        }
+
+        return style;
+    }();
+
+    return style;
+}
+
+void Element::cascade()
+{
+    auto& parentStyle = parent ? parent->style : initialStyle();
+    std::shared_ptr<ComputedStyle> newStyle;
+    for(auto& property : properties)
+    {
+        if(!isInheritedProperty(property.id) || property.value.empty() || property.value == InheritString)
+            continue;
+
+        if(newStyle == nullptr)
+            newStyle = std::make_shared<ComputedStyle>(*parentStyle);
+        applyStyle(*newStyle, property.id, property.value);
+    }
+
+    if(newStyle)
+        style = std::move(newStyle);
+    else
+        style = parentStyle;
+
+    for(auto& child : children)
+    {
+        if(!child->isText())
+            static_cast<Element*>(child)->cascade();
+    }
+}
+
 Rect Element::currentViewport() const
 {
     if(parent == nullptr)
@@ -2,9 +2,12 @@
 #define ELEMENT_H
 
 #include <memory>
-#include <list>
+#include <vector>
+#include <type_traits>
+#include <new>
 
 #include "property.h"
+#include "arena.h"
 
 namespace lunasvg {
 
@@ -106,6 +109,37 @@ enum class PropertyId
     Y2
 };
 
+// Parsed form of a property value, stored inline. Only small trivially
+// copyable results (lengths, colors, numbers, transforms, enums) fit here;
+// lists, paths and strings are cheaper to re-parse than to keep twice.
+class PropertyValue
+{
+public:
+    template<typename T>
+    using IsStorable = std::integral_constant<bool, std::is_trivially_copyable<T>::value && sizeof(T) <= 48 && alignof(T) <= alignof(double)>;
+
+    template<typename T>
+    const T* get(const void* type) const
+    {
+        if(m_type != type)
+            return nullptr;
+        return reinterpret_cast<const T*>(m_data);
+    }
+
+    template<typename T>
+    const T& set(const void* type, const T& value)
+    {
+        m_type = type;
+        return *new (m_data) T(value);
+    }
+
+    void reset() { m_type = nullptr; }
+
+private:
+    const void* m_type{nullptr};
+    alignas(double) unsigned char m_data[48];
+};
+
 struct Property
 {
     PropertyId id;
@@ -123,10 +157,73 @@ public:
     void add(const Property& property);
     void add(const PropertyList& properties);
 
+    std::vector<Property>::const_iterator begin() const { return m_properties.begin(); }
+    std::vector<Property>::const_iterator end() const { return m_properties.end(); }
+
+    // Parses the value of a property in this list at most once per distinct
+    // parse function when the result fits a PropertyValue, so later reads
+    // return the stored result.
+    template<typename Parse>
+    auto parsed(const Property* property, Parse parse) const
+    {
+        using T = decltype(parse(std::string{}));
+        if(property == nullptr)
+            return parse(std::string{});
+        return parsed(property, parse, PropertyValue::IsStorable<T>{});
+    }
+
 private:
+    template<typename Parse>
+    auto parsed(const Property* property, Parse parse, std::true_type) const
+    {
+        using T = decltype(parse(std::string{}));
+        static const char type = 0;
+        if(m_values.size() < m_properties.size())
+            m_values.resize(m_properties.size());
+
+        auto& slot = m_values[property - m_properties.data()];
+        if(auto value = slot.get<T>(&type))
+            return *value;
+        return slot.set(&type, parse(property->value));
+    }
+
+    template<typename Parse>
+    auto parsed(const Property* property, Parse parse, std::false_type) const
+    {
+        return parse(property->value);
+    }
+
     std::vector<Property> m_properties;
+    mutable std::vector<PropertyValue> m_values;
+};
+
+// Inherited properties, resolved once per element by Element::cascade().
+// Elements that declare none of them share their parent's style.
+struct ComputedStyle
+{
+    Paint fill;
+    Paint stroke;
+    Color color;
+    double fill_opacity;
+    double stroke_opacity;
+    double stroke_miterlimit;
+    Length stroke_width;
+    Length stroke_dashoffset;
+    LengthList stroke_dasharray;
+    WindRule fill_rule;
+    WindRule clip_rule;
+    LineCap stroke_linecap;
+    LineJoin stroke_linejoin;
+    Visibility visibility;
+    std::string marker_start;
+    std::string marker_mid;
+    std::string marker_end;
+    bool fillCurrentColor;
+    bool strokeCurrentColor;
 };
 
+bool isInheritedProperty(PropertyId id);
+
 class LayoutContext;
 class LayoutContainer;
 class Element;
@@ -141,10 +238,11 @@ public:
     virtual bool isPaint() const { return false; }
     virtual bool isGeometry() const { return false; }
     virtual void layout(LayoutContext*, LayoutContainer*) const;
-    virtual std::unique_ptr<Node> clone() const = 0;
+    virtual Node* clone(MemoryArena* arena) const = 0;
 
 public:
     Element* parent = nullptr;
+    std::size_t index = 0;
 };
 
 class TextNode : public Node
@@ -153,13 +251,13 @@ public:
     TextNode() = default;
 
     bool isText() const { return true; }
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 
 public:
     std::string text;
 };
 
-using NodeList = std::list<std::unique_ptr<Node>>;
+using NodeList = std::vector<Node*>;
 
 class Element : public Node
 {
@@ -169,12 +267,30 @@ public:
     void set(PropertyId id, const std::string& value, int specificity);
     const std::string& get(PropertyId id) const;
     const std::string& find(PropertyId id) const;
+    const Property* findProperty(PropertyId id, const Element** owner = nullptr) const;
     bool has(PropertyId id) const;
 
+    template<typename Parse>
+    auto getParsed(PropertyId id, Parse parse) const
+    {
+        return properties.parsed(properties.get(id), parse);
+    }
+
+    template<typename Parse>
+    auto findParsed(PropertyId id, Parse parse) const
+    {
+        const Element* owner = nullptr;
+        auto property = findProperty(id, &owner);
+        if(property == nullptr)
+            return parse(std::string{});
+        return owner->properties.parsed(property, parse);
+    }
+
     Element* previousSibling() const;
     Element* nextSibling() const;
-    Node* addChild(std::unique_ptr<Node> child);
+    Node* addChild(Node* child);
     void layoutChildren(LayoutContext* context, LayoutContainer* current) const;
+    void cascade();
     Rect currentViewport() const;
 
     template<typename T>
@@ -187,23 +303,23 @@ public:
         {
             if(child->isText())
             {
-                if(callback(child.get()))
+                if(callback(child))
                     return;
                 continue;
             }
 
-            auto element = static_cast<Element*>(child.get());
+            auto element = static_cast<Element*>(child);
             element->transverse(callback);
         }
     }
 
     template<typename T>
-    std::unique_ptr<T> cloneElement() const
+    T* cloneElement(MemoryArena* arena) const
     {
-        auto element = std::make_unique<T>();
+        auto element = arena->create<T>();
         element->properties = properties;
         for(auto& child : children)
-            element->addChild(child->clone());
+            element->addChild(child->clone(arena));
         return element;
     }
 
@@ -211,6 +327,7 @@ public:
     ElementId id;
     NodeList children;
     PropertyList properties;
+    std::shared_ptr<const ComputedStyle> style;
 };
 
 } // namespace lunasvg
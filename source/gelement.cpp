@@ -13,18 +13,18 @@ void GElement::layout(LayoutContext* context, LayoutContainer* current) const
     if(isDisplayNone())
         return;
 
-    auto group = std::make_unique<LayoutGroup>();
+    auto group = context->create<LayoutGroup>();
     group->transform = transform();
     group->opacity = opacity();
     group->masker = context->getMasker(mask());
     group->clipper = context->getClipper(clip_path());
-    layoutChildren(context, group.get());
-    current->addChildIfNotEmpty(std::move(group));
+    layoutChildren(context, group);
+    current->addChildIfNotEmpty(group);
 }
 
-std::unique_ptr<Node> GElement::clone() const
+Node* GElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<GElement>();
+    return cloneElement<GElement>(arena);
 }
 
 } // namespace lunasvg
@@ -11,7 +11,7 @@ public:
     GElement();
 
     void layout(LayoutContext* context, LayoutContainer* current) const;
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 } // namespace lunasvg
@@ -20,8 +20,9 @@ void GeometryElement::layout(LayoutContext* context, LayoutContainer* current) c
     if(path.empty())
         return;
 
-    auto shape = std::make_unique<LayoutShape>();
+    auto shape = context->create<LayoutShape>();
     shape->path = std::move(path);
+    shape->shapeInfo = ShapeInfo(shape->path);
     shape->transform = transform();
     shape->fillData = context->fillData(this);
     shape->strokeData = context->strokeData(this);
@@ -31,7 +32,7 @@ void GeometryElement::layout(LayoutContext* context, LayoutContainer* current) c
     shape->opacity = opacity();
     shape->masker = context->getMasker(mask());
     shape->clipper = context->getClipper(clip_path());
-    current->addChild(std::move(shape));
+    current->addChild(shape);
 }
 
 PathElement::PathElement()
@@ -50,9 +51,9 @@ Path PathElement::path() const
     return d();
 }
 
-std::unique_ptr<Node> PathElement::clone() const
+Node* PathElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<PathElement>();
+    return cloneElement<PathElement>(arena);
 }
 
 PolyElement::PolyElement(ElementId id)
@@ -86,9 +87,9 @@ Path PolygonElement::path() const
     return path;
 }
 
-std::unique_ptr<Node> PolygonElement::clone() const
+Node* PolygonElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<PolygonElement>();
+    return cloneElement<PolygonElement>(arena);
 }
 
 PolylineElement::PolylineElement()
@@ -110,9 +111,9 @@ Path PolylineElement::path() const
     return path;
 }
 
-std::unique_ptr<Node> PolylineElement::clone() const
+Node* PolylineElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<PolylineElement>();
+    return cloneElement<PolylineElement>(arena);
 }
 
 CircleElement::CircleElement()
@@ -122,20 +123,23 @@ CircleElement::CircleElement()
 
 Length CircleElement::cx() const
 {
-    auto& value = get(PropertyId::Cx);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Cx, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length CircleElement::cy() const
 {
-    auto& value = get(PropertyId::Cy);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Cy, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length CircleElement::r() const
 {
-    auto& value = get(PropertyId::R);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::R, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    });
 }
 
 Path CircleElement::path() const
@@ -154,9 +158,9 @@ Path CircleElement::path() const
     return path;
 }
 
-std::unique_ptr<Node> CircleElement::clone() const
+Node* CircleElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<CircleElement>();
+    return cloneElement<CircleElement>(arena);
 }
 
 EllipseElement::EllipseElement()
@@ -166,26 +170,30 @@ EllipseElement::EllipseElement()
 
 Length EllipseElement::cx() const
 {
-    auto& value = get(PropertyId::Cx);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Cx, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length EllipseElement::cy() const
 {
-    auto& value = get(PropertyId::Cy);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Cy, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length EllipseElement::rx() const
 {
-    auto& value = get(PropertyId::Rx);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Rx, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    });
 }
 
 Length EllipseElement::ry() const
 {
-    auto& value = get(PropertyId::Ry);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Ry, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    });
 }
 
 Path EllipseElement::path() const
@@ -206,9 +214,9 @@ Path EllipseElement::path() const
     return path;
 }
 
-std::unique_ptr<Node> EllipseElement::clone() const
+Node* EllipseElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<EllipseElement>();
+    return cloneElement<EllipseElement>(arena);
 }
 
 LineElement::LineElement()
@@ -218,26 +226,30 @@ LineElement::LineElement()
 
 Length LineElement::x1() const
 {
-    auto& value = get(PropertyId::X1);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::X1, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length LineElement::y1() const
 {
-    auto& value = get(PropertyId::Y1);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Y1, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length LineElement::x2() const
 {
-    auto& value = get(PropertyId::X2);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::X2, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length LineElement::y2() const
 {
-    auto& value = get(PropertyId::Y2);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Y2, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Path LineElement::path() const
@@ -254,9 +266,9 @@ Path LineElement::path() const
     return path;
 }
 
-std::unique_ptr<Node> LineElement::clone() const
+Node* LineElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<LineElement>();
+    return cloneElement<LineElement>(arena);
 }
 
 RectElement::RectElement()
@@ -266,38 +278,44 @@ RectElement::RectElement()
 
 Length RectElement::x() const
 {
-    auto& value = get(PropertyId::X);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::X, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length RectElement::y() const
 {
-    auto& value = get(PropertyId::Y);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Y, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length RectElement::rx() const
 {
-    auto& value = get(PropertyId::Rx);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::Unknown);
+    return getParsed(PropertyId::Rx, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::Unknown);
+    });
 }
 
 Length RectElement::ry() const
 {
-    auto& value = get(PropertyId::Ry);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::Unknown);
+    return getParsed(PropertyId::Ry, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::Unknown);
+    });
 }
 
 Length RectElement::width() const
 {
-    auto& value = get(PropertyId::Width);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Width, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    });
 }
 
 Length RectElement::height() const
 {
-    auto& value = get(PropertyId::Height);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Height, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    });
 }
 
 Path RectElement::path() const
@@ -327,9 +345,9 @@ Path RectElement::path() const
     return path;
 }
 
-std::unique_ptr<Node> RectElement::clone() const
+Node* RectElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<RectElement>();
+    return cloneElement<RectElement>(arena);
 }
 
 } // namespace lunasvg
@@ -25,7 +25,7 @@ public:
     Path d() const;
     Path path() const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 class PolyElement : public GeometryElement
@@ -43,7 +43,7 @@ public:
 
     Path path() const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 class PolylineElement : public PolyElement
@@ -53,7 +53,7 @@ public:
 
     Path path() const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 class CircleElement : public GeometryElement
@@ -67,7 +67,7 @@ public:
 
     Path path() const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 class EllipseElement : public GeometryElement
@@ -82,7 +82,7 @@ public:
 
     Path path() const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 class LineElement : public GeometryElement
@@ -97,7 +97,7 @@ public:
 
     Path path() const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 class RectElement : public GeometryElement
@@ -114,7 +114,7 @@ public:
 
     Path path() const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 } // namespace lunasvg
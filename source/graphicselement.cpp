@@ -10,8 +10,9 @@ GraphicsElement::GraphicsElement(ElementId id)
 
 Transform GraphicsElement::transform() const
 {
-    auto& value = get(PropertyId::Transform);
-    return Parser::parseTransform(value);
+    return getParsed(PropertyId::Transform, [](const std::string& value) {
+        return Parser::parseTransform(value);
+    });
 }
 
 } // namespace lunasvg
@@ -8,6 +8,8 @@
 #include "geometryelement.h"
 
 #include <cmath>
+#include <tuple>
+#include <algorithm>
 
 namespace lunasvg {
 
@@ -68,18 +70,18 @@ const Rect& LayoutContainer::strokeBoundingBox() const
     return m_strokeBoundingBox;
 }
 
-LayoutObject* LayoutContainer::addChild(std::unique_ptr<LayoutObject> child)
+LayoutObject* LayoutContainer::addChild(LayoutObject* child)
 {
-    children.push_back(std::move(child));
-    return &*children.back();
+    children.push_back(child);
+    return child;
 }
 
-LayoutObject* LayoutContainer::addChildIfNotEmpty(std::unique_ptr<LayoutContainer> child)
+LayoutObject* LayoutContainer::addChildIfNotEmpty(LayoutContainer* child)
 {
     if(child->children.empty())
         return nullptr;
 
-    return addChild(std::move(child));
+    return addChild(child);
 }
 
 void LayoutContainer::renderChildren(RenderState& state) const
@@ -96,7 +98,6 @@ LayoutClipPath::LayoutClipPath()
 void LayoutClipPath::apply(RenderState& state) const
 {
     RenderState newState(this, RenderMode::Clipping);
-    newState.canvas = Canvas::create(state.canvas, state.canvas->box());
     newState.transform = transform * state.transform;
     if(units == Units::ObjectBoundingBox)
     {
@@ -105,8 +106,30 @@ void LayoutClipPath::apply(RenderState& state) const
         newState.transform.scale(box.w, box.h);
     }
 
-    renderChildren(newState);
-    if(clipper) clipper->apply(newState);
+    if(!state.canvas->isRaster())
+    {
+        newState.canvas = Canvas::create(state.canvas, state.canvas->box());
+        renderChildren(newState);
+        if(clipper) clipper->apply(newState);
+        state.canvas->blend(newState.canvas.get(), BlendMode::Dst_In, 1.0);
+        return;
+    }
+
+    // A raster mask only depends on the clip and its effective transform, so
+    // every object clipped the same way in this render reuses the first one.
+    // Pixels of the group outside the mask's box are outside the clip.
+    auto bounds = newState.transform.map(strokeBoundingBox());
+    auto box = bounds & state.canvas->box();
+    newState.canvas = state.canvas->findClip(this, newState.transform, box);
+    if(newState.canvas == nullptr)
+    {
+        newState.canvas = state.canvas->createClip(this, newState.transform, bounds, box);
+        renderChildren(newState);
+        if(clipper) clipper->apply(newState);
+    }
+
+    if(!newState.canvas->box().contains(state.canvas->box()))
+        state.canvas->mask(newState.canvas->box(), Transform());
     state.canvas->blend(newState.canvas.get(), BlendMode::Dst_In, 1.0);
 }
 
@@ -155,6 +178,9 @@ void LayoutSymbol::render(RenderState& state) const
     BlendInfo info{clipper, masker, opacity, clip};
     RenderState newState(this, state.mode());
     newState.transform = transform * state.transform;
+    if(state.canvas->isOutside(newState.transform.map(strokeBoundingBox())))
+        return;
+
     newState.beginGroup(state, info);
     renderChildren(newState);
     newState.endGroup(state, info);
@@ -175,6 +201,9 @@ void LayoutGroup::render(RenderState& state) const
     BlendInfo info{clipper, masker, opacity, Rect::Invalid};
     RenderState newState(this, state.mode());
     newState.transform = transform * state.transform;
+    if(state.canvas->isOutside(newState.transform.map(strokeBoundingBox())))
+        return;
+
     newState.beginGroup(state, info);
     renderChildren(newState);
     newState.endGroup(state, info);
@@ -185,6 +214,115 @@ Rect LayoutGroup::map(const Rect& rect) const
     return transform.map(rect);
 }
 
+LayoutInstance::LayoutInstance()
+    : LayoutObject(LayoutId::Instance)
+{
+}
+
+void LayoutInstance::render(RenderState& state) const
+{
+    BlendInfo info{clipper, masker, opacity, Rect::Invalid};
+    RenderState newState(this, state.mode());
+    newState.transform = transform * state.transform;
+    if(state.canvas->isOutside(newState.transform.map(strokeBoundingBox())))
+        return;
+
+    // Only command lists can be recorded and replayed. Scissor boxes recorded
+    // inside the content are mapped by the submit transform, which keeps them
+    // exact only without rotation or flips.
+    auto& m = newState.transform;
+    if(!cacheable || state.mode() != RenderMode::Display || state.canvas->isRaster() || m.m10 != 0.0 || m.m01 != 0.0 || m.m00 <= 0.0 || m.m11 <= 0.0)
+    {
+        newState.beginGroup(state, info);
+        content->render(newState);
+        newState.endGroup(state, info);
+        return;
+    }
+
+    auto canvas = state.canvas->findInstance(content);
+    if(canvas == nullptr)
+    {
+        RenderState contentState(content, RenderMode::Display);
+        contentState.canvas = state.canvas->createInstance(content, strokeBoundingBox());
+        content->render(contentState);
+        canvas = contentState.canvas;
+    }
+
+    // Opacity alone is a multiplied color on the submit; a clip or mask still
+    // needs its own group.
+    if(!clipper && !masker)
+    {
+        state.canvas->submit(canvas.get(), newState.transform, opacity * state.opacity);
+        return;
+    }
+
+    newState.beginGroup(state, info);
+    newState.canvas->submit(canvas.get(), newState.transform, 1.0);
+    newState.endGroup(state, info);
+}
+
+Rect LayoutInstance::map(const Rect& rect) const
+{
+    return transform.map(rect);
+}
+
+const Rect& LayoutInstance::fillBoundingBox() const
+{
+    if(m_fillBoundingBox.valid() || content->isHidden())
+        return m_fillBoundingBox;
+
+    m_fillBoundingBox.unite(content->map(content->fillBoundingBox()));
+    return m_fillBoundingBox;
+}
+
+const Rect& LayoutInstance::strokeBoundingBox() const
+{
+    if(m_strokeBoundingBox.valid() || content->isHidden())
+        return m_strokeBoundingBox;
+
+    m_strokeBoundingBox.unite(content->map(content->strokeBoundingBox()));
+    return m_strokeBoundingBox;
+}
+
+bool LayoutInstance::isCacheable(const LayoutObject* object)
+{
+    // Gradients are set up in device space, and masks, clip paths and markers
+    // render through their own state, so only plain painted geometry records.
+    switch(object->id)
+    {
+    case LayoutId::Shape: {
+        auto shape = static_cast<const LayoutShape*>(object);
+        return !shape->fillData.painter && !shape->strokeData.painter && shape->markerData.positions.empty() && !shape->masker && !shape->clipper;
+    }
+    case LayoutId::Instance: {
+        auto instance = static_cast<const LayoutInstance*>(object);
+        return !instance->masker && !instance->clipper && isCacheable(instance->content);
+    }
+    case LayoutId::Group: {
+        auto group = static_cast<const LayoutGroup*>(object);
+        if(group->masker || group->clipper)
+            return false;
+        break;
+    }
+    case LayoutId::Symbol: {
+        auto symbol = static_cast<const LayoutSymbol*>(object);
+        if(symbol->masker || symbol->clipper)
+            return false;
+        break;
+    }
+    default:
+        return false;
+    }
+
+    for(auto child : static_cast<const LayoutContainer*>(object)->children)
+    {
+        if(!isCacheable(child))
+            return false;
+    }
+
+    return true;
+}
+
 LayoutMarker::LayoutMarker()
     : LayoutContainer(LayoutId::Marker)
 {
@@ -288,7 +426,7 @@ void LayoutLinearGradient::apply(RenderState& state) const
         transform *= Transform(box.w, 0, 0, box.h, box.x, box.y);
     }
 
-    state.canvas->setLinearGradient(x1, y1, x2, y2, stops, spreadMethod, transform);
+    state.canvas->setLinearGradient(x1, y1, x2, y2, stops, packedStops, spreadMethod, transform);
 }
 
 LayoutRadialGradient::LayoutRadialGradient()
@@ -305,7 +443,7 @@ void LayoutRadialGradient::apply(RenderState& state) const
         transform *= Transform(box.w, 0, 0, box.h, box.x, box.y);
     }
 
-    state.canvas->setRadialGradient(cx, cy, r, fx, fy, stops, spreadMethod, transform);
+    state.canvas->setRadialGradient(cx, cy, r, fx, fy, stops, packedStops, spreadMethod, transform);
 }
 
 LayoutSolidColor::LayoutSolidColor()
@@ -318,7 +456,7 @@ void LayoutSolidColor::apply(RenderState& state) const
     state.canvas->setColor(color);
 }
 
-void FillData::fill(RenderState& state, const Path& path) const
+void FillData::fill(RenderState& state, const Path& path, const ShapeInfo& info) const
 {
     if(opacity == 0.0 || (painter == nullptr && color.isNone()))
         return;
@@ -328,10 +466,10 @@ void FillData::fill(RenderState& state, const Path& path) const
     else
         painter->apply(state);
 
-    state.canvas->fill(path, state.transform, fillRule, BlendMode::Src_Over, opacity);
+    state.canvas->fill(path, info, state.transform, fillRule, BlendMode::Src_Over, opacity * state.opacity);
 }
 
-void StrokeData::stroke(RenderState& state, const Path& path) const
+void StrokeData::stroke(RenderState& state, const Path& path, const ShapeInfo& info) const
 {
     if(opacity == 0.0 || (painter == nullptr && color.isNone()))
         return;
@@ -341,7 +479,7 @@ void StrokeData::stroke(RenderState& state, const Path& path) const
     else
         painter->apply(state);
 
-    state.canvas->stroke(path, state.transform, width, cap, join, miterlimit, dash, BlendMode::Src_Over, opacity);
+    state.canvas->stroke(path, info, state.transform, width, cap, join, miterlimit, dash, BlendMode::Src_Over, opacity * state.opacity);
 }
 
 static const double sqrt2 = 1.41421356237309504880;
@@ -401,18 +539,21 @@ void LayoutShape::render(RenderState& state) const
     BlendInfo info{clipper, masker, opacity, Rect::Invalid};
     RenderState newState(this, state.mode());
     newState.transform = transform * state.transform;
+    if(state.canvas->isOutside(newState.transform.map(strokeBoundingBox())))
+        return;
+
     newState.beginGroup(state, info);
 
     if(newState.mode() == RenderMode::Display)
     {
-        fillData.fill(newState, path);
-        strokeData.stroke(newState, path);
+        fillData.fill(newState, path, shapeInfo);
+        strokeData.stroke(newState, path, shapeInfo);
         markerData.render(newState);
     }
     else
     {
         newState.canvas->setColor(Color::Black);
-        newState.canvas->fill(path, newState.transform, clipRule, BlendMode::Src, 1.0);
+        newState.canvas->fill(path, shapeInfo, newState.transform, clipRule, BlendMode::Src, 1.0);
     }
 
     newState.endGroup(state, info);
@@ -448,12 +589,199 @@ RenderState::RenderState(const LayoutObject* object, RenderMode mode)
 {
 }
 
+static bool collectPaintBoxes(const LayoutObject* object, const Transform& transform, std::vector<Rect>& boxes);
+
+// A child with its own opacity or mask reaches its parent as a single paint
+// over its whole box, drawn through a layer or itself free of overlaps. A
+// clip may be a scissor rather than a layer, so clipped content counts as
+// its paints, which the clip only shrinks.
+static bool collectChildBoxes(const LayoutObject* child, const Transform& transform, std::vector<Rect>& boxes)
+{
+    if(child->isHidden())
+        return true;
+
+    Transform childTransform;
+    bool composited = false;
+    switch(child->id)
+    {
+    case LayoutId::Shape: {
+        auto shape = static_cast<const LayoutShape*>(child);
+        if(shape->visibility == Visibility::Hidden)
+            return true;
+        childTransform = shape->transform * transform;
+        composited = shape->opacity < 1.0 || shape->masker;
+        break;
+    }
+    case LayoutId::Group: {
+        auto group = static_cast<const LayoutGroup*>(child);
+        childTransform = group->transform * transform;
+        composited = group->opacity < 1.0 || group->masker;
+        break;
+    }
+    case LayoutId::Symbol: {
+        auto symbol = static_cast<const LayoutSymbol*>(child);
+        childTransform = symbol->transform * transform;
+        composited = symbol->opacity < 1.0 || symbol->masker;
+        break;
+    }
+    case LayoutId::Instance: {
+        auto instance = static_cast<const LayoutInstance*>(child);
+        childTransform = instance->transform * transform;
+        composited = instance->opacity < 1.0 || instance->masker;
+        break;
+    }
+    default:
+        return false;
+    }
+
+    if(!composited)
+        return collectPaintBoxes(child, childTransform, boxes);
+    boxes.push_back(childTransform.map(child->strokeBoundingBox()));
+    return true;
+}
+
+// Collects the device boxes of the paints that draw an object, or fails when
+// one of its shapes paints more than once, as a fill under a stroke or
+// markers, and so overlaps itself.
+static bool collectPaintBoxes(const LayoutObject* object, const Transform& transform, std::vector<Rect>& boxes)
+{
+    switch(object->id)
+    {
+    case LayoutId::Shape: {
+        auto shape = static_cast<const LayoutShape*>(object);
+        const auto& fill = shape->fillData;
+        const auto& stroke = shape->strokeData;
+        auto fills = fill.opacity != 0.0 && (fill.painter || !fill.color.isNone());
+        auto strokes = stroke.opacity != 0.0 && (stroke.painter || !stroke.color.isNone());
+        if((fills && strokes) || !shape->markerData.positions.empty())
+            return false;
+        if(fills || strokes)
+            boxes.push_back(transform.map(shape->strokeBoundingBox()));
+        return true;
+    }
+    case LayoutId::Symbol:
+    case LayoutId::Group:
+        for(auto child : static_cast<const LayoutContainer*>(object)->children)
+        {
+            if(!collectChildBoxes(child, transform, boxes))
+                return false;
+        }
+
+        return true;
+    case LayoutId::Instance:
+        return collectChildBoxes(static_cast<const LayoutInstance*>(object)->content, transform, boxes);
+    default:
+        return false;
+    }
+}
+
+// The whole pixels a device box can touch, grown by a pixel for antialiasing.
+static Rect pixelBounds(const Rect& box)
+{
+    auto x = std::floor(box.x - 1.0);
+    auto y = std::floor(box.y - 1.0);
+    auto r = std::ceil(box.x + box.w + 1.0);
+    auto b = std::ceil(box.y + box.h + 1.0);
+    return Rect{x, y, r - x, b - y};
+}
+
+// Group opacity can be multiplied into the paints instead of blending a layer
+// when no two paints touch a common pixel.
+static bool canDistributeOpacity(const LayoutObject* object, const Transform& transform)
+{
+    std::vector<Rect> boxes;
+    if(!collectPaintBoxes(object, transform, boxes))
+        return false;
+    if(boxes.size() < 2)
+        return true;
+
+    for(auto& box : boxes)
+        box = pixelBounds(box);
+
+    std::sort(boxes.begin(), boxes.end(), [](const Rect& a, const Rect& b) { return a.x < b.x; });
+    for(std::size_t i = 0; i < boxes.size(); ++i)
+    {
+        const auto& a = boxes[i];
+        for(auto j = i + 1; j < boxes.size() && boxes[j].x < a.x + a.w; ++j)
+        {
+            const auto& b = boxes[j];
+            if(b.y < a.y + a.h && a.y < b.y + b.h)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static bool isAxisAligned(const Transform& transform)
+{
+    return (transform.m10 == 0.0 && transform.m01 == 0.0) || (transform.m00 == 0.0 && transform.m11 == 0.0);
+}
+
+// Under an axis-aligned transform, a viewport clip or a rectangular clip path
+// covers exactly a device rectangle, which the canvas can scissor to.
+static bool clipRect(const LayoutObject* object, const Transform& transform, const BlendInfo& info, Rect& rect)
+{
+    rect = Rect::Invalid;
+    if(!info.clip.valid() && !info.clipper)
+        return true;
+
+    if(info.clip.valid())
+    {
+        if(!isAxisAligned(transform))
+            return false;
+        rect = transform.map(info.clip);
+    }
+
+    if(auto clipper = info.clipper)
+    {
+        if(!clipper->rect.valid())
+            return false;
+
+        auto clipTransform = clipper->transform * transform;
+        if(clipper->units == Units::ObjectBoundingBox)
+        {
+            const auto& box = object->fillBoundingBox();
+            clipTransform.translate(box.x, box.y);
+            clipTransform.scale(box.w, box.h);
+        }
+
+        if(!isAxisAligned(clipTransform))
+            return false;
+        rect.intersect(clipTransform.map(clipper->rect));
+    }
+
+    // Only the object's own pixels need clipping, and bounding the clip by
+    // them keeps a raster one small. Whole pixels past its antialiasing cut
+    // nothing the object draws.
+    auto box = transform.map(object->strokeBoundingBox());
+    if(box.valid() && rect.valid())
+        rect.intersect(pixelBounds(box));
+    if(!rect.valid())
+        rect = Rect::Empty;
+    return true;
+}
+
 void RenderState::beginGroup(RenderState& state, const BlendInfo& info)
 {
-    if(!info.clipper && !info.clip.valid() && (m_mode == RenderMode::Display && !(info.masker || info.opacity < 1.0)))
+    Rect clip;
+    if(!info.masker && m_mode == RenderMode::Display && clipRect(m_object, transform, info, clip))
     {
-        canvas = state.canvas;
-        return;
+        auto clipped = info.clipper || info.clip.valid();
+        if(info.opacity >= 1.0 || canDistributeOpacity(m_object, transform))
+        {
+            canvas = state.canvas;
+            opacity = state.opacity * info.opacity;
+            if(clipped)
+            {
+                canvas->pushClip(clip);
+                m_clipped = true;
+            }
+
+            if(clipped || info.opacity < 1.0)
+                canvas->elideLayer();
+            return;
+        }
     }
 
     auto box = transform.map(m_object->strokeBoundingBox());
@@ -465,7 +793,11 @@ void RenderState::beginGroup(RenderState& state, const BlendInfo& info)
 void RenderState::endGroup(RenderState& state, const BlendInfo& info)
 {
     if(state.canvas == canvas)
+    {
+        if(m_clipped)
+            canvas->popClip();
         return;
+    }
 
     if(info.clipper)
         info.clipper->apply(*this);
@@ -476,11 +808,40 @@ void RenderState::endGroup(RenderState& state, const BlendInfo& info)
     if(info.clip.valid())
         canvas->mask(info.clip, transform);
 
-    state.canvas->blend(canvas.get(), BlendMode::Src_Over, m_mode == RenderMode::Display ? info.opacity : 1.0);
+    state.canvas->blend(canvas.get(), BlendMode::Src_Over, m_mode == RenderMode::Display ? info.opacity * state.opacity : 1.0);
 }
 
-LayoutContext::LayoutContext(const ParseDocument* document, LayoutSymbol* root)
-    : m_document(document), m_root(root)
+void computeBoundingBoxes(const LayoutObject* object)
+{
+    object->fillBoundingBox();
+    object->strokeBoundingBox();
+    switch(object->id)
+    {
+    case LayoutId::Instance:
+        computeBoundingBoxes(static_cast<const LayoutInstance*>(object)->content);
+        break;
+    case LayoutId::Symbol:
+    case LayoutId::Group:
+    case LayoutId::Mask:
+    case LayoutId::ClipPath:
+    case LayoutId::Marker:
+    case LayoutId::Pattern:
+        for(auto child : static_cast<const LayoutContainer*>(object)->children)
+            computeBoundingBoxes(child);
+        break;
+    default:
+        break;
+    }
+}
+
+bool InstanceKey::operator<(const InstanceKey& other) const
+{
+    return std::tie(element, parentStyle, declarations, viewportElement, width, height)
+        < std::tie(other.element, other.parentStyle, other.declarations, other.viewportElement, other.width, other.height);
+}
+
+LayoutContext::LayoutContext(const ParseDocument* document, LayoutSymbol* root, MemoryArena* arena)
+    : m_document(document), m_root(root), m_arena(arena)
 {
 }
 
@@ -498,13 +859,13 @@ LayoutObject* LayoutContext::getResourcesById(const std::string& id) const
     return it->second;
 }
 
-LayoutObject* LayoutContext::addToResourcesCache(const std::string& id, std::unique_ptr<LayoutObject> resources)
+LayoutObject* LayoutContext::addToResourcesCache(const std::string& id, LayoutObject* resources)
 {
     if(resources == nullptr)
         return nullptr;
 
-    m_resourcesCache.emplace(id, resources.get());
-    return m_root->addChild(std::move(resources));
+    m_resourcesCache.emplace(id, resources);
+    return m_root->addChild(resources);
 }
 
 LayoutMask* LayoutContext::getMasker(const std::string& id)
@@ -521,7 +882,7 @@ LayoutMask* LayoutContext::getMasker(const std::string& id)
         return nullptr;
 
     auto masker = static_cast<MaskElement*>(element)->getMasker(this);
-    return static_cast<LayoutMask*>(addToResourcesCache(id, std::move(masker)));
+    return static_cast<LayoutMask*>(addToResourcesCache(id, masker));
 }
 
 LayoutClipPath* LayoutContext::getClipper(const std::string& id)
@@ -538,7 +899,7 @@ LayoutClipPath* LayoutContext::getClipper(const std::string& id)
         return nullptr;
 
     auto clipper = static_cast<ClipPathElement*>(element)->getClipper(this);
-    return static_cast<LayoutClipPath*>(addToResourcesCache(id, std::move(clipper)));
+    return static_cast<LayoutClipPath*>(addToResourcesCache(id, clipper));
 }
 
 LayoutMarker* LayoutContext::getMarker(const std::string& id)
@@ -555,7 +916,7 @@ LayoutMarker* LayoutContext::getMarker(const std::string& id)
         return nullptr;
 
     auto marker = static_cast<MarkerElement*>(element)->getMarker(this);
-    return static_cast<LayoutMarker*>(addToResourcesCache(id, std::move(marker)));
+    return static_cast<LayoutMarker*>(addToResourcesCache(id, marker));
 }
 
 LayoutObject* LayoutContext::getPainter(const std::string& id)
@@ -572,7 +933,7 @@ LayoutObject* LayoutContext::getPainter(const std::string& id)
         return nullptr;
 
     auto painter = static_cast<PaintElement*>(element)->getPainter(this);
-    return addToResourcesCache(id, std::move(painter));
+    return addToResourcesCache(id, painter);
 }
 
 FillData LayoutContext::fillData(const StyledElement* element)
@@ -581,17 +942,18 @@ FillData LayoutContext::fillData(const StyledElement* element)
     if(fill.isNone())
         return FillData{};
 
+    auto& style = *element->style;
     FillData fillData;
     fillData.painter = getPainter(fill.ref());
     fillData.color = fill.color();
-    fillData.opacity = element->fill_opacity();
-    fillData.fillRule = element->fill_rule();
+    fillData.opacity = style.fill_opacity;
+    fillData.fillRule = style.fill_rule;
     return fillData;
 }
 
 DashData LayoutContext::dashData(const StyledElement* element)
 {
-    auto dasharray = element->stroke_dasharray();
+    auto& dasharray = element->style->stroke_dasharray;
     if(dasharray.empty())
         return DashData{};
 
@@ -619,7 +981,7 @@ DashData LayoutContext::dashData(const StyledElement* element)
     if(sum == 0.0)
         return DashData{};
 
-    auto offset = lengthContex.valueForLength(element->stroke_dashoffset(), LengthMode::Both);
+    auto offset = lengthContex.valueForLength(element->style->stroke_dashoffset, LengthMode::Both);
     dashData.offset = std::fmod(offset, sum);
     if(dashData.offset < 0.0)
         dashData.offset += sum;
@@ -633,15 +995,16 @@ StrokeData LayoutContext::strokeData(const StyledElement* element)
     if(stroke.isNone())
         return StrokeData{};
 
+    auto& style = *element->style;
     LengthContext lengthContex(element);
     StrokeData strokeData;
     strokeData.painter = getPainter(stroke.ref());
     strokeData.color = stroke.color();
-    strokeData.opacity = element->stroke_opacity();
-    strokeData.width = lengthContex.valueForLength(element->stroke_width(), LengthMode::Both);
-    strokeData.miterlimit = element->stroke_miterlimit();
-    strokeData.cap = element->stroke_linecap();
-    strokeData.join = element->stroke_linejoin();
+    strokeData.opacity = style.stroke_opacity;
+    strokeData.width = lengthContex.valueForLength(style.stroke_width, LengthMode::Both);
+    strokeData.miterlimit = style.stroke_miterlimit;
+    strokeData.cap = style.stroke_linecap;
+    strokeData.join = style.stroke_linejoin;
     strokeData.dash = dashData(element);
     return strokeData;
 }
@@ -650,16 +1013,17 @@ static const double pi = 3.14159265358979323846;
 
 MarkerData LayoutContext::markerData(const GeometryElement* element, const Path& path)
 {
-    auto markerStart = getMarker(element->marker_start());
-    auto markerMid = getMarker(element->marker_mid());
-    auto markerEnd = getMarker(element->marker_end());
+    auto& style = *element->style;
+    auto markerStart = getMarker(style.marker_start);
+    auto markerMid = getMarker(style.marker_mid);
+    auto markerEnd = getMarker(style.marker_end);
 
     if(markerStart == nullptr && markerMid == nullptr && markerEnd == nullptr)
         return MarkerData{};
 
     LengthContext lengthContex(element);
     MarkerData markerData;
-    markerData.strokeWidth = lengthContex.valueForLength(element->stroke_width(), LengthMode::Both);
+    markerData.strokeWidth = lengthContex.valueForLength(style.stroke_width, LengthMode::Both);
 
     PathIterator it(path);
     Point origin;
@@ -747,9 +1111,41 @@ void LayoutContext::removeReference(const Element* element)
     m_references.erase(element);
 }
 
-bool LayoutContext::hasReference(const Element* element) const
+// Uses met while an instance is being built belong to scratch clones whose
+// styles and ancestors are freed afterwards, so they are never cached.
+bool LayoutContext::findInstance(const InstanceKey& key, LayoutInstance* instance)
+{
+    if(m_instanceDepth > 0)
+        return false;
+
+    auto it = m_instanceCache.find(key);
+    if(it == m_instanceCache.end())
+        return false;
+
+    // Recording only pays off once a second instance shows up, so the first
+    // one is marked cacheable here rather than when it is laid out.
+    auto first = it->second.first;
+    first->cacheable = it->second.second;
+    instance->content = first->content;
+    instance->cacheable = first->cacheable;
+    return true;
+}
+
+void LayoutContext::addInstance(const InstanceKey& key, LayoutInstance* instance, bool cacheable)
 {
-    return m_references.count(element);
+    if(m_instanceDepth > 0)
+        return;
+
+    m_instanceCache.emplace(key, std::make_pair(instance, cacheable));
+}
+
+bool LayoutContext::hasReference(const Element* element)
+{
+    if(m_references.count(element) == 0)
+        return false;
+
+    ++m_referenceBreaks;
+    return true;
 }
 
 LayoutBreaker::LayoutBreaker(LayoutContext* context, const Element* element)
@@ -3,8 +3,8 @@
 
 #include "property.h"
 #include "canvas.h"
+#include "arena.h"
 
-#include <list>
 #include <map>
 #include <set>
 
@@ -14,6 +14,7 @@ enum class LayoutId
 {
     Symbol,
     Group,
+    Instance,
     Shape,
     Mask,
     ClipPath,
@@ -37,33 +38,67 @@ public:
 
     virtual const Rect& fillBoundingBox() const { return Rect::Invalid;}
     virtual const Rect& strokeBoundingBox() const { return Rect::Invalid;}
-    virtual size_t estimateMemoryUsage() const { return sizeof(*this); }
 
     bool isPaint() const { return id == LayoutId::LinearGradient || id == LayoutId::RadialGradient || id == LayoutId::Pattern || id == LayoutId::SolidColor; }
     bool isHidden() const { return isPaint() || id == LayoutId::ClipPath || id == LayoutId::Mask || id == LayoutId::Marker; }
 
 public:
     LayoutId id;
+
+private:
+    friend class LayoutList;
+    LayoutObject* m_nextSibling{nullptr};
 };
 
-using LayoutList = std::list<std::unique_ptr<LayoutObject>>;
+// Children are chained through the objects themselves, so a layout tree living
+// in a MemoryArena needs no allocation besides the objects.
+class LayoutList
+{
+public:
+    class const_iterator
+    {
+    public:
+        explicit const_iterator(LayoutObject* object) : m_object(object) {}
+
+        LayoutObject* operator*() const { return m_object; }
+        const_iterator& operator++() { m_object = m_object->m_nextSibling; return *this; }
+        bool operator==(const const_iterator& other) const { return m_object == other.m_object; }
+        bool operator!=(const const_iterator& other) const { return m_object != other.m_object; }
+
+    private:
+        LayoutObject* m_object;
+    };
+
+    const_iterator begin() const { return const_iterator(m_first); }
+    const_iterator end() const { return const_iterator(nullptr); }
+
+    bool empty() const { return m_first == nullptr; }
+    LayoutObject* back() const { return m_last; }
+
+    void push_back(LayoutObject* object)
+    {
+        if(m_last)
+            m_last->m_nextSibling = object;
+        else
+            m_first = object;
+        m_last = object;
+    }
+
+private:
+    LayoutObject* m_first{nullptr};
+    LayoutObject* m_last{nullptr};
+};
 
 class LayoutContainer : public LayoutObject
 {
 public:
-    virtual size_t estimateMemoryUsage() const {
-        size_t estimate = sizeof(*this);
-        for (auto& child : this->children)
-            estimate += child->estimateMemoryUsage();
-        return estimate;
-    }
     LayoutContainer(LayoutId id);
 
     const Rect& fillBoundingBox() const;
     const Rect& strokeBoundingBox() const;
 
-    LayoutObject* addChild(std::unique_ptr<LayoutObject> child);
-    LayoutObject* addChildIfNotEmpty(std::unique_ptr<LayoutContainer> child);
+    LayoutObject* addChild(LayoutObject* child);
+    LayoutObject* addChildIfNotEmpty(LayoutContainer* child);
     void renderChildren(RenderState& state) const;
 
 public:
@@ -85,6 +120,7 @@ public:
     Units units;
     Transform transform;
     const LayoutClipPath* clipper;
+    Rect rect{Rect::Invalid};
 };
 
 class LayoutMask : public LayoutContainer
@@ -139,6 +175,34 @@ public:
     const LayoutClipPath* clipper;
 };
 
+// Placement of a layout subtree shared by every <use> that resolves to the
+// same content; the subtree itself is never owned by a container. Cacheable
+// content is recorded into one command list that every instance submits.
+class LayoutInstance : public LayoutObject
+{
+public:
+    LayoutInstance();
+
+    void render(RenderState& state) const;
+    Rect map(const Rect& rect) const;
+    const Rect& fillBoundingBox() const;
+    const Rect& strokeBoundingBox() const;
+
+    static bool isCacheable(const LayoutObject* object);
+
+public:
+    const LayoutObject* content;
+    bool cacheable;
+    Transform transform;
+    double opacity;
+    const LayoutMask* masker;
+    const LayoutClipPath* clipper;
+
+private:
+    mutable Rect m_fillBoundingBox{Rect::Invalid};
+    mutable Rect m_strokeBoundingBox{Rect::Invalid};
+};
+
 class LayoutMarker : public LayoutContainer
 {
 public:
@@ -189,6 +253,7 @@ public:
     SpreadMethod spreadMethod;
     Units units;
     GradientStops stops;
+    PackedStops packedStops;
 };
 
 class LayoutLinearGradient : public LayoutGradient
@@ -236,7 +301,7 @@ class FillData
 public:
     FillData() = default;
 
-    void fill(RenderState& state, const Path& path) const;
+    void fill(RenderState& state, const Path& path, const ShapeInfo& info) const;
 
 public:
     const LayoutObject* painter{nullptr};
@@ -250,7 +315,7 @@ class StrokeData
 public:
     StrokeData() = default;
 
-    void stroke(RenderState& state, const Path& path) const;
+    void stroke(RenderState& state, const Path& path, const ShapeInfo& info) const;
     void inflate(Rect& box) const;
 
 public:
@@ -303,6 +368,7 @@ public:
 
 public:
     Path path;
+    ShapeInfo shapeInfo;
     Transform transform;
     FillData fillData;
     StrokeData strokeData;
@@ -347,24 +413,47 @@ public:
 public:
     std::shared_ptr<Canvas> canvas;
     Transform transform;
+    double opacity{1.0};
 
 private:
     const LayoutObject* m_object;
     RenderMode m_mode;
+    bool m_clipped{false};
 };
 
+// Bounding boxes are computed on first use and cached in the objects. Filling
+// them all up front leaves the tree read-only while it renders, so several
+// threads can share it.
+void computeBoundingBoxes(const LayoutObject* object);
+
 class ParseDocument;
 class StyledElement;
 class GeometryElement;
+struct ComputedStyle;
+
+struct InstanceKey
+{
+    const Element* element;
+    const ComputedStyle* parentStyle;
+    std::string declarations;
+    const Element* viewportElement;
+    std::string width;
+    std::string height;
+
+    bool operator<(const InstanceKey& other) const;
+};
 
 class LayoutContext
 {
 public:
-    LayoutContext(const ParseDocument* document, LayoutSymbol* root);
+    LayoutContext(const ParseDocument* document, LayoutSymbol* root, MemoryArena* arena);
+
+    template<typename T>
+    T* create() { return m_arena->create<T>(); }
 
     Element* getElementById(const std::string& id) const;
     LayoutObject* getResourcesById(const std::string& id) const;
-    LayoutObject* addToResourcesCache(const std::string& id, std::unique_ptr<LayoutObject> resources);
+    LayoutObject* addToResourcesCache(const std::string& id, LayoutObject* resources);
     LayoutMask* getMasker(const std::string& id);
     LayoutClipPath* getClipper(const std::string& id);
     LayoutMarker* getMarker(const std::string& id);
@@ -375,15 +464,25 @@ public:
     StrokeData strokeData(const StyledElement* element);
     MarkerData markerData(const GeometryElement* element, const Path& path);
 
+    bool findInstance(const InstanceKey& key, LayoutInstance* instance);
+    void addInstance(const InstanceKey& key, LayoutInstance* instance, bool cacheable);
+    void enterInstance() { ++m_instanceDepth; }
+    void leaveInstance() { --m_instanceDepth; }
+
     void addReference(const Element* element);
     void removeReference(const Element* element);
-    bool hasReference(const Element* element) const;
+    bool hasReference(const Element* element);
+    std::size_t referenceBreaks() const { return m_referenceBreaks; }
 
 private:
     const ParseDocument* m_document;
     LayoutSymbol* m_root;
+    MemoryArena* m_arena;
     std::map<std::string, LayoutObject*> m_resourcesCache;
+    std::map<InstanceKey, std::pair<LayoutInstance*, bool>> m_instanceCache;
+    int m_instanceDepth{0};
     std::set<const Element*> m_references;
+    std::size_t m_referenceBreaks{0};
 };
 
 class LayoutBreaker
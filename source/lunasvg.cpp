@@ -5,6 +5,19 @@
 #include <fstream>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace lunasvg {
 
@@ -74,7 +87,35 @@ std::uint32_t Bitmap::stride() const
     return m_impl ? m_impl->stride : 0;
 }
 
-void Bitmap::clear(std::uint32_t color)
+// Rows are split into one band per thread. Bitmaps with fewer pixels than
+// this per thread are done on the calling thread, as starting threads would
+// cost more than the pass itself.
+static const std::uint64_t kMinPixelsPerThread = 1 << 18;
+
+template<typename Function>
+static void forEachRowBand(std::uint32_t width, std::uint32_t height, std::uint32_t threadCount, Function function)
+{
+    if(threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    auto maxThreads = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(width) * height / kMinPixelsPerThread);
+    threadCount = static_cast<std::uint32_t>(std::min<std::uint64_t>({threadCount, maxThreads, height}));
+    if(threadCount <= 1)
+    {
+        function(0u, height);
+        return;
+    }
+
+    auto band = (height + threadCount - 1) / threadCount;
+    std::vector<std::thread> threads;
+    for(std::uint32_t y = band; y < height; y += band)
+        threads.emplace_back(function, y, std::min(height, y + band));
+    function(0u, band);
+    for(auto& thread : threads)
+        thread.join();
+}
+
+void Bitmap::clear(std::uint32_t color, std::uint32_t threadCount)
 {
     auto r = (color >> 24) & 0xFF;
     auto g = (color >> 16) & 0xFF;
@@ -88,55 +129,112 @@ void Bitmap::clear(std::uint32_t color)
     auto width = this->width();
     auto height = this->height();
     auto stride = this->stride();
-    auto rowData = this->data();
+    auto data = this->data();
 
-    for(std::uint32_t y = 0;y < height;y++)
-    {
-        auto data = rowData;
+    // One row is filled a pixel at a time, every other row is a copy of it.
+    const std::uint8_t pixel[4] = {std::uint8_t(pb), std::uint8_t(pg), std::uint8_t(pr), std::uint8_t(a)};
+    auto fillRow = [&](std::uint8_t* row) {
         for(std::uint32_t x = 0;x < width;x++)
+            std::memcpy(row + x * 4, pixel, 4);
+    };
+
+    forEachRowBand(width, height, threadCount, [&](std::uint32_t begin, std::uint32_t end) {
+        if(begin == end)
+            return;
+
+        auto first = data + begin * stride;
+        fillRow(first);
+        for(auto y = begin + 1;y < end;y++)
+            std::memcpy(data + y * stride, first, width * 4);
+    });
+}
+
+// floor(v * 255 / a) equals (v * table[a]) >> 16 for every byte v and alpha
+// a, since the rounding error of the reciprocal stays below 1 / a as long as
+// 255 * 255 < 65536. The products fit in 32 bits.
+static const std::uint32_t* unpremultiplyTable()
+{
+    static const auto table = [] {
+        std::vector<std::uint32_t> table(256, 0);
+        for(std::uint32_t a = 1;a < 256;a++)
+            table[a] = (255 * 65536 + a - 1) / a;
+        return table;
+    }();
+
+    return table.data();
+}
+
+static void convertRow(const std::uint8_t* src, std::uint8_t* dst, std::uint32_t width, int ri, int gi, int bi, int ai, bool unpremultiply, const std::uint32_t* table)
+{
+    for(std::uint32_t x = 0;x < width;x++)
+    {
+        std::uint32_t b = src[0];
+        std::uint32_t g = src[1];
+        std::uint32_t r = src[2];
+        std::uint32_t a = src[3];
+
+        if(unpremultiply && a != 0 && a != 255)
         {
-            data[0] = pb;
-            data[1] = pg;
-            data[2] = pr;
-            data[3] = a;
-            data += 4;
+            auto inv = table[a];
+            r = (r * inv) >> 16;
+            g = (g * inv) >> 16;
+            b = (b * inv) >> 16;
         }
-        rowData += stride;
+
+        dst[ri] = std::uint8_t(r);
+        dst[gi] = std::uint8_t(g);
+        dst[bi] = std::uint8_t(b);
+        dst[ai] = std::uint8_t(a);
+        src += 4;
+        dst += 4;
     }
 }
 
-void Bitmap::convert(int ri, int gi, int bi, int ai, bool unpremultiply)
+void Bitmap::convert(int ri, int gi, int bi, int ai, bool unpremultiply, std::uint32_t threadCount)
 {
     auto width = this->width();
     auto height = this->height();
     auto stride = this->stride();
-    auto rowData = this->data();
+    auto data = this->data();
+    auto table = unpremultiplyTable();
 
-    for(std::uint32_t y = 0;y < height;y++)
-    {
-        auto data = rowData;
-        for(std::uint32_t x = 0;x < width;x++)
+    forEachRowBand(width, height, threadCount, [&](std::uint32_t begin, std::uint32_t end) {
+        for(auto y = begin;y < end;y++)
         {
-            auto b = data[0];
-            auto g = data[1];
-            auto r = data[2];
-            auto a = data[3];
+            auto row = data + y * stride;
+            convertRow(row, row, width, ri, gi, bi, ai, unpremultiply, table);
+        }
+    });
+}
 
-            if(unpremultiply && a != 0)
+void Bitmap::convertTo(PixelFormat format, std::uint8_t* dest, std::uint32_t destStride, std::uint32_t threadCount) const
+{
+    auto width = this->width();
+    auto height = this->height();
+    auto stride = this->stride();
+    auto data = this->data();
+    auto table = unpremultiplyTable();
+
+    forEachRowBand(width, height, threadCount, [&](std::uint32_t begin, std::uint32_t end) {
+        for(auto y = begin;y < end;y++)
+        {
+            auto src = data + y * stride;
+            auto dst = dest + y * destStride;
+            switch(format)
             {
-                r = (r * 255) / a;
-                g = (g * 255) / a;
-                b = (b * 255) / a;
+            case PixelFormat::RGBA8:
+                convertRow(src, dst, width, 0, 1, 2, 3, true, table);
+                break;
+            case PixelFormat::BGRA8:
+                convertRow(src, dst, width, 2, 1, 0, 3, true, table);
+                break;
+            case PixelFormat::A8:
+                for(std::uint32_t x = 0;x < width;x++)
+                    dst[x] = src[x * 4 + 3];
+                break;
             }
-
-            data[ri] = r;
-            data[gi] = g;
-            data[bi] = b;
-            data[ai] = a;
-            data += 4;
         }
-        rowData += stride;
-    }
+    });
 }
 
 Box::Box(double x, double y, double w, double h)
@@ -262,17 +360,111 @@ Matrix Matrix::translated(double tx, double ty)
     return Transform::translated(tx, ty);
 }
 
+class FileMapping
+{
+public:
+    FileMapping(const std::string& filename);
+    ~FileMapping();
+
+    bool isOpen() const { return m_data != nullptr; }
+    const char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+private:
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+
+    const char* m_data{nullptr};
+    std::size_t m_size{0};
+#ifdef _WIN32
+    HANDLE m_file{INVALID_HANDLE_VALUE};
+    HANDLE m_mapping{nullptr};
+#endif
+};
+
+#ifdef _WIN32
+FileMapping::FileMapping(const std::string& filename)
+{
+    m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(m_file == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+        return;
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(m_mapping == nullptr)
+        return;
+
+    m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if(m_data != nullptr)
+        m_size = static_cast<std::size_t>(size.QuadPart);
+}
+
+FileMapping::~FileMapping()
+{
+    if(m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if(m_mapping != nullptr)
+        CloseHandle(m_mapping);
+    if(m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+}
+#else
+FileMapping::FileMapping(const std::string& filename)
+{
+    auto fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd == -1)
+        return;
+
+    struct stat st;
+    if(::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        auto size = static_cast<std::size_t>(st.st_size);
+        auto data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data != MAP_FAILED)
+        {
+#ifdef POSIX_MADV_SEQUENTIAL
+            ::posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+#endif
+            m_data = static_cast<const char*>(data);
+            m_size = size;
+        }
+    }
+
+    ::close(fd);
+}
+
+FileMapping::~FileMapping()
+{
+    if(m_data != nullptr)
+        ::munmap(const_cast<char*>(m_data), m_size);
+}
+#endif
+
 std::unique_ptr<Document> Document::loadFromFile(const std::string& filename)
 {
-    std::ifstream fs;
-    fs.open(filename);
+    FileMapping mapping(filename);
+    if(mapping.isOpen())
+        return loadFromData(mapping.data(), mapping.size());
+
+    std::ifstream fs(filename, std::ios::binary);
     if(!fs.is_open())
         return nullptr;
 
     std::string content;
-    std::getline(fs, content, '\0');
-    fs.close();
+    fs.seekg(0, std::ios::end);
+    auto size = fs.tellg();
+    if(size > 0)
+    {
+        content.resize(static_cast<std::size_t>(size));
+        fs.seekg(0, std::ios::beg);
+        fs.read(&content[0], size);
+        content.resize(static_cast<std::size_t>(fs.gcount()));
+    }
 
+    fs.close();
     return loadFromData(content);
 }
 
@@ -287,12 +479,11 @@ std::unique_ptr<Document> Document::loadFromData(const char* data, std::size_t s
     if(!parser.parse(data, size))
         return nullptr;
 
-    auto root = parser.layout();
-    if(!root || root->children.empty())
+    std::unique_ptr<Document> document(new Document);
+    document->root = parser.layout(document->arena.get());
+    if(!document->root || document->root->children.empty())
         return nullptr;
 
-    std::unique_ptr<Document> document(new Document);
-    document->root = std::move(root);
     return document;
 }
 
@@ -374,6 +565,7 @@ std::vector<vg::CommandListHandle> Document::render(vg::CommandListRef cl, const
     state.canvas = Canvas::create(cl, 0., 0., root->width, root->height);
     state.transform = Transform(matrix.a, matrix.b, matrix.c, matrix.d, matrix.e, matrix.f);
     root->render(state);
+    elidedLayers += state.canvas->elidedLayers();
     state.canvas->rgba();
     return state.canvas->child();
 }
@@ -387,11 +579,111 @@ std::vector<vg::CommandListHandle> Document::renderToBitmap(vg::CommandListRef c
     return render(cl, matrix);
 }
 
-size_t Document::estimateMemoryUsage() const {
-    return this->root->estimateMemoryUsage();
+void Document::render(Bitmap bitmap, const Matrix& matrix) const
+{
+    if(!bitmap.valid())
+        return;
+
+    RenderState state(nullptr, RenderMode::Display);
+    state.canvas = Canvas::create(bitmap.data(), bitmap.width(), bitmap.height(), bitmap.stride());
+    state.transform = Transform(matrix);
+    root->render(state);
+    elidedLayers += state.canvas->elidedLayers();
+}
+
+void Document::render(Bitmap bitmap, const Matrix& matrix, std::uint32_t threadCount) const
+{
+    if(!bitmap.valid())
+        return;
+
+    if(threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // Every tile renders the whole tree into its own window of the bitmap;
+    // subtrees whose bounds miss the window are skipped, which bins shapes to
+    // the tiles they touch while groups, clips and masks still composite in
+    // order. Aim for a few tiles per thread so uneven tiles balance out,
+    // without going so small that shapes get rasterized over and over.
+    auto width = bitmap.width();
+    auto height = bitmap.height();
+    auto area = static_cast<double>(width) * height;
+    auto tileSize = static_cast<std::uint32_t>(std::ceil(std::sqrt(area / (threadCount * 4.0)) / 64.0)) * 64;
+    tileSize = std::max(tileSize, 128u);
+
+    auto columns = (width + tileSize - 1) / tileSize;
+    auto rows = (height + tileSize - 1) / tileSize;
+    auto tileCount = columns * rows;
+    threadCount = std::min(threadCount, tileCount);
+    if(threadCount <= 1)
+    {
+        render(bitmap, matrix);
+        return;
+    }
+
+    computeBoundingBoxes(root);
+
+    std::atomic<std::uint32_t> nextTile{0};
+    auto renderTiles = [&] {
+        for(auto tile = nextTile++; tile < tileCount; tile = nextTile++)
+        {
+            auto x = (tile % columns) * tileSize;
+            auto y = (tile / columns) * tileSize;
+            auto data = bitmap.data() + y * bitmap.stride() + x * 4;
+
+            RenderState state(nullptr, RenderMode::Display);
+            state.canvas = Canvas::create(data, x, y, std::min(tileSize, width - x), std::min(tileSize, height - y), bitmap.stride());
+            state.transform = Transform(matrix);
+            root->render(state);
+            elidedLayers += state.canvas->elidedLayers();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(std::uint32_t i = 1; i < threadCount; ++i)
+        threads.emplace_back(renderTiles);
+    renderTiles();
+    for(auto& thread : threads)
+        thread.join();
+}
+
+Bitmap Document::renderToBitmap(std::uint32_t width, std::uint32_t height, std::uint32_t backgroundColor) const
+{
+    if(root->width == 0.0 || root->height == 0.0)
+        return Bitmap{};
+
+    if(width == 0 && height == 0)
+    {
+        width = static_cast<std::uint32_t>(std::ceil(root->width));
+        height = static_cast<std::uint32_t>(std::ceil(root->height));
+    }
+    else if(width != 0 && height == 0)
+    {
+        height = static_cast<std::uint32_t>(std::ceil(width * root->height / root->width));
+    }
+    else if(height != 0 && width == 0)
+    {
+        width = static_cast<std::uint32_t>(std::ceil(height * root->width / root->height));
+    }
+
+    Matrix matrix(width / root->width, 0, 0, height / root->height, 0, 0);
+    Bitmap bitmap(width, height);
+    bitmap.clear(backgroundColor);
+    render(bitmap, matrix);
+    return bitmap;
+}
+
+size_t Document::estimateMemoryUsage() const
+{
+    return arena->bytesReserved();
+}
+
+size_t Document::elidedLayerCount() const
+{
+    return elidedLayers;
 }
 
 Document::Document()
+    : arena(std::make_unique<MemoryArena>())
 {
 }
 
@@ -11,53 +11,61 @@ MarkerElement::MarkerElement()
 
 Length MarkerElement::refX() const
 {
-    auto& value = get(PropertyId::RefX);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::RefX, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length MarkerElement::refY() const
 {
-    auto& value = get(PropertyId::RefY);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::RefY, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length MarkerElement::markerWidth() const
 {
-    auto& value = get(PropertyId::MarkerWidth);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::ThreePercent);
+    return getParsed(PropertyId::MarkerWidth, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::ThreePercent);
+    });
 }
 
 Length MarkerElement::markerHeight() const
 {
-    auto& value = get(PropertyId::MarkerHeight);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::ThreePercent);
+    return getParsed(PropertyId::MarkerHeight, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::ThreePercent);
+    });
 }
 
 Angle MarkerElement::orient() const
 {
-    auto& value = get(PropertyId::Orient);
-    return Parser::parseAngle(value);
+    return getParsed(PropertyId::Orient, [](const std::string& value) {
+        return Parser::parseAngle(value);
+    });
 }
 
 MarkerUnits MarkerElement::markerUnits() const
 {
-    auto& value = get(PropertyId::MarkerUnits);
-    return Parser::parseMarkerUnits(value);
+    return getParsed(PropertyId::MarkerUnits, [](const std::string& value) {
+        return Parser::parseMarkerUnits(value);
+    });
 }
 
 Rect MarkerElement::viewBox() const
 {
-    auto& value = get(PropertyId::ViewBox);
-    return Parser::parseViewBox(value);
+    return getParsed(PropertyId::ViewBox, [](const std::string& value) {
+        return Parser::parseViewBox(value);
+    });
 }
 
 PreserveAspectRatio MarkerElement::preserveAspectRatio() const
 {
-    auto& value = get(PropertyId::PreserveAspectRatio);
-    return Parser::parsePreserveAspectRatio(value);
+    return getParsed(PropertyId::PreserveAspectRatio, [](const std::string& value) {
+        return Parser::parsePreserveAspectRatio(value);
+    });
 }
 
-std::unique_ptr<LayoutMarker> MarkerElement::getMarker(LayoutContext* context) const
+LayoutMarker* MarkerElement::getMarker(LayoutContext* context) const
 {
     auto markerWidth = this->markerWidth();
     auto markerHeight = this->markerHeight();
@@ -76,7 +84,7 @@ std::unique_ptr<LayoutMarker> MarkerElement::getMarker(LayoutContext* context) c
     viewTransform.map(_refX, _refY, &_refX, &_refY);
 
     LayoutBreaker layoutBreaker(context, this);
-    auto marker = std::make_unique<LayoutMarker>();
+    auto marker = context->create<LayoutMarker>();
     marker->refX = _refX;
     marker->refY = _refY;
     marker->transform = viewTransform;
@@ -86,13 +94,13 @@ std::unique_ptr<LayoutMarker> MarkerElement::getMarker(LayoutContext* context) c
     marker->opacity = opacity();
     marker->masker = context->getMasker(mask());
     marker->clipper = context->getClipper(clip_path());
-    layoutChildren(context, marker.get());
+    layoutChildren(context, marker);
     return marker;
 }
 
-std::unique_ptr<Node> MarkerElement::clone() const
+Node* MarkerElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<MarkerElement>();
+    return cloneElement<MarkerElement>(arena);
 }
 
 } // namespace lunasvg
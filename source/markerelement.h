@@ -21,9 +21,9 @@ public:
 
     Rect viewBox() const;
     PreserveAspectRatio preserveAspectRatio() const;
-    std::unique_ptr<LayoutMarker> getMarker(LayoutContext* context) const;
+    LayoutMarker* getMarker(LayoutContext* context) const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 } // namespace lunasvg
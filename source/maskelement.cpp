@@ -11,41 +11,47 @@ MaskElement::MaskElement()
 
 Length MaskElement::x() const
 {
-    auto& value = get(PropertyId::X);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::MinusTenPercent);
+    return getParsed(PropertyId::X, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::MinusTenPercent);
+    });
 }
 
 Length MaskElement::y() const
 {
-    auto& value = get(PropertyId::Y);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::MinusTenPercent);
+    return getParsed(PropertyId::Y, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::MinusTenPercent);
+    });
 }
 
 Length MaskElement::width() const
 {
-    auto& value = get(PropertyId::Width);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::OneTwentyPercent);
+    return getParsed(PropertyId::Width, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::OneTwentyPercent);
+    });
 }
 
 Length MaskElement::height() const
 {
-    auto& value = get(PropertyId::Height);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::OneTwentyPercent);
+    return getParsed(PropertyId::Height, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::OneTwentyPercent);
+    });
 }
 
 Units MaskElement::maskUnits() const
 {
-    auto& value = get(PropertyId::MaskUnits);
-    return Parser::parseUnits(value, Units::ObjectBoundingBox);
+    return getParsed(PropertyId::MaskUnits, [](const std::string& value) {
+        return Parser::parseUnits(value, Units::ObjectBoundingBox);
+    });
 }
 
 Units MaskElement::maskContentUnits() const
 {
-    auto& value = get(PropertyId::MaskContentUnits);
-    return Parser::parseUnits(value, Units::UserSpaceOnUse);
+    return getParsed(PropertyId::MaskContentUnits, [](const std::string& value) {
+        return Parser::parseUnits(value, Units::UserSpaceOnUse);
+    });
 }
 
-std::unique_ptr<LayoutMask> MaskElement::getMasker(LayoutContext* context) const
+LayoutMask* MaskElement::getMasker(LayoutContext* context) const
 {
     auto w = this->width();
     auto h = this->height();
@@ -53,7 +59,7 @@ std::unique_ptr<LayoutMask> MaskElement::getMasker(LayoutContext* context) const
         return nullptr;
 
     LayoutBreaker layoutBreaker(context, this);
-    auto masker = std::make_unique<LayoutMask>();
+    auto masker = context->create<LayoutMask>();
     masker->units = maskUnits();
     masker->contentUnits = maskContentUnits();
     masker->opacity = opacity();
@@ -65,13 +71,13 @@ std::unique_ptr<LayoutMask> MaskElement::getMasker(LayoutContext* context) const
     masker->y = lengthContext.valueForLength(y(), LengthMode::Height);
     masker->width = lengthContext.valueForLength(w, LengthMode::Width);
     masker->height = lengthContext.valueForLength(h, LengthMode::Height);
-    layoutChildren(context, masker.get());
+    layoutChildren(context, masker);
     return masker;
 }
 
-std::unique_ptr<Node> MaskElement::clone() const
+Node* MaskElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<MaskElement>();
+    return cloneElement<MaskElement>(arena);
 }
 
 } // namespace lunasvg
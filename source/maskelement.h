@@ -18,9 +18,9 @@ public:
     Length height() const;
     Units maskUnits() const;
     Units maskContentUnits() const;
-    std::unique_ptr<LayoutMask> getMasker(LayoutContext* context) const;
+    LayoutMask* getMasker(LayoutContext* context) const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 } // namespace lunasvg
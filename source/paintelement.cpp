@@ -19,20 +19,23 @@ GradientElement::GradientElement(ElementId id)
 
 Transform GradientElement::gradientTransform() const
 {
-    auto& value = get(PropertyId::GradientTransform);
-    return Parser::parseTransform(value);
+    return getParsed(PropertyId::GradientTransform, [](const std::string& value) {
+        return Parser::parseTransform(value);
+    });
 }
 
 SpreadMethod GradientElement::spreadMethod() const
 {
-    auto& value = get(PropertyId::SpreadMethod);
-    return Parser::parseSpreadMethod(value);
+    return getParsed(PropertyId::SpreadMethod, [](const std::string& value) {
+        return Parser::parseSpreadMethod(value);
+    });
 }
 
 Units GradientElement::gradientUnits() const
 {
-    auto& value = get(PropertyId::GradientUnits);
-    return Parser::parseUnits(value, Units::ObjectBoundingBox);
+    return getParsed(PropertyId::GradientUnits, [](const std::string& value) {
+        return Parser::parseUnits(value, Units::ObjectBoundingBox);
+    });
 }
 
 std::string GradientElement::href() const
@@ -49,7 +52,7 @@ GradientStops GradientElement::buildGradientStops() const
     {
         if(child->isText())
             continue;
-        auto element = static_cast<Element*>(child.get());
+        auto element = static_cast<Element*>(child);
         if(element->id != ElementId::Stop)
             continue;
         auto stop = static_cast<StopElement*>(element);
@@ -68,29 +71,33 @@ LinearGradientElement::LinearGradientElement()
 
 Length LinearGradientElement::x1() const
 {
-    auto& value = get(PropertyId::X1);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::X1, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length LinearGradientElement::y1() const
 {
-    auto& value = get(PropertyId::Y1);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Y1, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length LinearGradientElement::x2() const
 {
-    auto& value = get(PropertyId::X2);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::HundredPercent);
+    return getParsed(PropertyId::X2, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::HundredPercent);
+    });
 }
 
 Length LinearGradientElement::y2() const
 {
-    auto& value = get(PropertyId::Y2);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Y2, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
-std::unique_ptr<LayoutObject> LinearGradientElement::getPainter(LayoutContext* context) const
+LayoutObject* LinearGradientElement::getPainter(LayoutContext* context) const
 {
     LinearGradientAttributes attributes;
     std::set<const GradientElement*> processedGradients;
@@ -141,26 +148,27 @@ std::unique_ptr<LayoutObject> LinearGradientElement::getPainter(LayoutContext* c
     auto y2 = lengthContext.valueForLength(attributes.y2(), LengthMode::Height);
     if((x1 == x2 && y1 == y2) || stops.size() == 1)
     {
-        auto solid = std::make_unique<LayoutSolidColor>();
+        auto solid = context->create<LayoutSolidColor>();
         solid->color = std::get<1>(stops.back());
-        return std::move(solid);
+        return solid;
     }
 
-    auto gradient = std::make_unique<LayoutLinearGradient>();
+    auto gradient = context->create<LayoutLinearGradient>();
     gradient->transform = attributes.gradientTransform();
     gradient->spreadMethod = attributes.spreadMethod();
     gradient->units = attributes.gradientUnits();
     gradient->stops = attributes.gradientStops();
+    gradient->packedStops = PackedStops(gradient->stops);
     gradient->x1 = x1;
     gradient->y1 = y1;
     gradient->x2 = x2;
     gradient->y2 = y2;
-    return std::move(gradient);
+    return gradient;
 }
 
-std::unique_ptr<Node> LinearGradientElement::clone() const
+Node* LinearGradientElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<LinearGradientElement>();
+    return cloneElement<LinearGradientElement>(arena);
 }
 
 RadialGradientElement::RadialGradientElement()
@@ -170,35 +178,40 @@ RadialGradientElement::RadialGradientElement()
 
 Length RadialGradientElement::cx() const
 {
-    auto& value = get(PropertyId::Cx);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::FiftyPercent);
+    return getParsed(PropertyId::Cx, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::FiftyPercent);
+    });
 }
 
 Length RadialGradientElement::cy() const
 {
-    auto& value = get(PropertyId::Cy);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::FiftyPercent);
+    return getParsed(PropertyId::Cy, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::FiftyPercent);
+    });
 }
 
 Length RadialGradientElement::r() const
 {
-    auto& value = get(PropertyId::R);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::FiftyPercent);
+    return getParsed(PropertyId::R, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::FiftyPercent);
+    });
 }
 
 Length RadialGradientElement::fx() const
 {
-    auto& value = get(PropertyId::Fx);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Fx, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length RadialGradientElement::fy() const
 {
-    auto& value = get(PropertyId::Fy);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Fy, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
-std::unique_ptr<LayoutObject> RadialGradientElement::getPainter(LayoutContext* context) const
+LayoutObject* RadialGradientElement::getPainter(LayoutContext* context) const
 {
     RadialGradientAttributes attributes;
     std::set<const GradientElement*> processedGradients;
@@ -252,16 +265,17 @@ std::unique_ptr<LayoutObject> RadialGradientElement::getPainter(LayoutContext* c
     auto& r = attributes.r();
     if(r.isZero() || stops.size() == 1)
     {
-        auto solid = std::make_unique<LayoutSolidColor>();
+        auto solid = context->create<LayoutSolidColor>();
         solid->color = std::get<1>(stops.back());
-        return std::move(solid);
+        return solid;
     }
 
-    auto gradient = std::make_unique<LayoutRadialGradient>();
+    auto gradient = context->create<LayoutRadialGradient>();
     gradient->transform = attributes.gradientTransform();
     gradient->spreadMethod = attributes.spreadMethod();
     gradient->units = attributes.gradientUnits();
     gradient->stops = attributes.gradientStops();
+    gradient->packedStops = PackedStops(gradient->stops);
 
     LengthContext lengthContext(this, attributes.gradientUnits());
     gradient->cx = lengthContext.valueForLength(attributes.cx(), LengthMode::Width);
@@ -269,12 +283,12 @@ std::unique_ptr<LayoutObject> RadialGradientElement::getPainter(LayoutContext* c
     gradient->r = lengthContext.valueForLength(attributes.r(), LengthMode::Both);
     gradient->fx = lengthContext.valueForLength(attributes.fx(), LengthMode::Width);
     gradient->fy = lengthContext.valueForLength(attributes.fy(), LengthMode::Height);
-    return std::move(gradient);
+    return gradient;
 }
 
-std::unique_ptr<Node> RadialGradientElement::clone() const
+Node* RadialGradientElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<RadialGradientElement>();
+    return cloneElement<RadialGradientElement>(arena);
 }
 
 PatternElement::PatternElement()
@@ -284,56 +298,65 @@ PatternElement::PatternElement()
 
 Length PatternElement::x() const
 {
-    auto& value = get(PropertyId::X);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::X, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length PatternElement::y() const
 {
-    auto& value = get(PropertyId::Y);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Y, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length PatternElement::width() const
 {
-    auto& value = get(PropertyId::Width);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Width, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    });
 }
 
 Length PatternElement::height() const
 {
-    auto& value = get(PropertyId::Height);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Height, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::Zero);
+    });
 }
 
 Transform PatternElement::patternTransform() const
 {
-    auto& value = get(PropertyId::PatternTransform);
-    return Parser::parseTransform(value);
+    return getParsed(PropertyId::PatternTransform, [](const std::string& value) {
+        return Parser::parseTransform(value);
+    });
 }
 
 Units PatternElement::patternUnits() const
 {
-    auto& value = get(PropertyId::PatternUnits);
-    return Parser::parseUnits(value, Units::ObjectBoundingBox);
+    return getParsed(PropertyId::PatternUnits, [](const std::string& value) {
+        return Parser::parseUnits(value, Units::ObjectBoundingBox);
+    });
 }
 
 Units PatternElement::patternContentUnits() const
 {
-    auto& value = get(PropertyId::PatternContentUnits);
-    return Parser::parseUnits(value, Units::UserSpaceOnUse);
+    return getParsed(PropertyId::PatternContentUnits, [](const std::string& value) {
+        return Parser::parseUnits(value, Units::UserSpaceOnUse);
+    });
 }
 
 Rect PatternElement::viewBox() const
 {
-    auto& value = get(PropertyId::ViewBox);
-    return Parser::parseViewBox(value);
+    return getParsed(PropertyId::ViewBox, [](const std::string& value) {
+        return Parser::parseViewBox(value);
+    });
 }
 
 PreserveAspectRatio PatternElement::preserveAspectRatio() const
 {
-    auto& value = get(PropertyId::PreserveAspectRatio);
-    return Parser::parsePreserveAspectRatio(value);
+    return getParsed(PropertyId::PreserveAspectRatio, [](const std::string& value) {
+        return Parser::parsePreserveAspectRatio(value);
+    });
 }
 
 std::string PatternElement::href() const
@@ -342,7 +365,7 @@ std::string PatternElement::href() const
     return Parser::parseHref(value);
 }
 
-std::unique_ptr<LayoutObject> PatternElement::getPainter(LayoutContext* context) const
+LayoutObject* PatternElement::getPainter(LayoutContext* context) const
 {
     if(context->hasReference(this))
         return nullptr;
@@ -391,7 +414,7 @@ std::unique_ptr<LayoutObject> PatternElement::getPainter(LayoutContext* context)
         return nullptr;
 
     LayoutBreaker layoutBreaker(context, this);
-    auto pattern = std::make_unique<LayoutPattern>();
+    auto pattern = context->create<LayoutPattern>();
     pattern->transform = attributes.patternTransform();
     pattern->units = attributes.patternUnits();
     pattern->contentUnits = attributes.patternContentUnits();
@@ -403,13 +426,13 @@ std::unique_ptr<LayoutObject> PatternElement::getPainter(LayoutContext* context)
     pattern->y = lengthContext.valueForLength(attributes.y(), LengthMode::Height);
     pattern->width = lengthContext.valueForLength(attributes.width(), LengthMode::Width);
     pattern->height = lengthContext.valueForLength(attributes.height(), LengthMode::Height);
-    element->layoutChildren(context, pattern.get());
-    return std::move(pattern);
+    element->layoutChildren(context, pattern);
+    return pattern;
 }
 
-std::unique_ptr<Node> PatternElement::clone() const
+Node* PatternElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<PatternElement>();
+    return cloneElement<PatternElement>(arena);
 }
 
 SolidColorElement::SolidColorElement()
@@ -417,17 +440,17 @@ SolidColorElement::SolidColorElement()
 {
 }
 
-std::unique_ptr<LayoutObject> SolidColorElement::getPainter(LayoutContext*) const
+LayoutObject* SolidColorElement::getPainter(LayoutContext* context) const
 {
-    auto solid = std::make_unique<LayoutSolidColor>();
+    auto solid = context->create<LayoutSolidColor>();
     solid->color = solid_color();
     solid->color.a = solid_opacity();
-    return std::move(solid);
+    return solid;
 }
 
-std::unique_ptr<Node> SolidColorElement::clone() const
+Node* SolidColorElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<SolidColorElement>();
+    return cloneElement<SolidColorElement>(arena);
 }
 
 } // namespace lunasvg
@@ -14,7 +14,7 @@ public:
     PaintElement(ElementId id);
 
     bool isPaint() const { return true; }
-    virtual std::unique_ptr<LayoutObject> getPainter(LayoutContext* context) const = 0;
+    virtual LayoutObject* getPainter(LayoutContext* context) const = 0;
 };
 
 class GradientElement : public PaintElement
@@ -39,8 +39,8 @@ public:
     Length x2() const;
     Length y2() const;
 
-    std::unique_ptr<LayoutObject> getPainter(LayoutContext* context) const;
-    std::unique_ptr<Node> clone() const;
+    LayoutObject* getPainter(LayoutContext* context) const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 class RadialGradientElement : public GradientElement
@@ -54,8 +54,8 @@ public:
     Length fx() const;
     Length fy() const;
 
-    std::unique_ptr<LayoutObject> getPainter(LayoutContext* context) const;
-    std::unique_ptr<Node> clone() const;
+    LayoutObject* getPainter(LayoutContext* context) const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 class PatternElement : public PaintElement
@@ -75,8 +75,8 @@ public:
     PreserveAspectRatio preserveAspectRatio() const;
     std::string href() const;
 
-    std::unique_ptr<LayoutObject> getPainter(LayoutContext* context) const;
-    std::unique_ptr<Node> clone() const;
+    LayoutObject* getPainter(LayoutContext* context) const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 class SolidColorElement : public PaintElement
@@ -84,8 +84,8 @@ class SolidColorElement : public PaintElement
 public:
     SolidColorElement();
 
-    std::unique_ptr<LayoutObject> getPainter(LayoutContext*) const;
-    std::unique_ptr<Node> clone() const;
+    LayoutObject* getPainter(LayoutContext* context) const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 class GradientAttributes
@@ -519,7 +519,7 @@ Units Parser::parseUnits(const std::string& string, Units defaultValue)
     return defaultValue;
 }
 
-static const std::map<std::string, unsigned int> colormap = {
+static constexpr NameEntry<unsigned int> colorentries[] = {
     {"aliceblue", 0xF0F8FF},
     {"antiquewhite", 0xFAEBD7},
     {"aqua", 0x00FFFF},
@@ -670,6 +670,8 @@ static const std::map<std::string, unsigned int> colormap = {
     {"yellowgreen", 0x9ACD32}
 };
 
+static constexpr NameTable<unsigned int, sizeof(colorentries) / sizeof(colorentries[0]), 2048> colormap(colorentries);
+
 Color Parser::parseColor(const std::string& string, const StyledElement* element, const Color& defaultValue)
 {
     if(string.empty())
@@ -724,11 +726,10 @@ Color Parser::parseColor(const std::string& string, const StyledElement* element
     if(Utils::skipDesc(ptr, end, "currentColor"))
         return element->color();
 
-    auto it = colormap.find(string);
-    if(it == colormap.end())
+    auto value = colormap.find(string, 0xFFFFFFFF);
+    if(value == 0xFFFFFFFF)
         return defaultValue;
 
-    auto value = it->second;
     auto r = (value&0xff0000)>>16;
     auto g = (value&0x00ff00)>>8;
     auto b = (value&0x0000ff)>>0;
@@ -848,7 +849,7 @@ bool Parser::parseLength(const char*& ptr, const char* end, double& value, Lengt
             units = LengthUnits::Px;
         else if(c[1] == 'c')
             units = LengthUnits::Pc;
-        else if(ptr[1] == 't')
+        else if(c[1] == 't')
             units = LengthUnits::Pt;
         else
             return false;
@@ -998,7 +999,7 @@ bool Parser::parseTransform(const char*& ptr, const char* end, TransformType& ty
     return true;
 }
 
-static const std::map<std::string, ElementId> elementmap = {
+static constexpr NameEntry<ElementId> elemententries[] = {
     {"circle", ElementId::Circle},
     {"clipPath", ElementId::ClipPath},
     {"defs", ElementId::Defs},
@@ -1022,7 +1023,9 @@ static const std::map<std::string, ElementId> elementmap = {
     {"use", ElementId::Use}
 };
 
-static const std::map<std::string, PropertyId> propertymap = {
+static constexpr NameTable<ElementId, sizeof(elemententries) / sizeof(elemententries[0]), 64> elementmap(elemententries);
+
+static constexpr NameEntry<PropertyId> propertyentries[] = {
     {"class", PropertyId::Class},
     {"clipPathUnits", PropertyId::ClipPathUnits},
     {"cx", PropertyId::Cx},
@@ -1066,7 +1069,9 @@ static const std::map<std::string, PropertyId> propertymap = {
     {"y2", PropertyId::Y2}
 };
 
-static const std::map<std::string, PropertyId> csspropertymap = {
+static constexpr NameTable<PropertyId, sizeof(propertyentries) / sizeof(propertyentries[0]), 256> propertymap(propertyentries);
+
+static constexpr NameEntry<PropertyId> csspropertyentries[] = {
     {"clip-path", PropertyId::Clip_Path},
     {"clip-rule", PropertyId::Clip_Rule},
     {"color", PropertyId::Color},
@@ -1095,31 +1100,25 @@ static const std::map<std::string, PropertyId> csspropertymap = {
     {"visibility", PropertyId::Visibility}
 };
 
+static constexpr NameTable<PropertyId, sizeof(csspropertyentries) / sizeof(csspropertyentries[0]), 128> csspropertymap(csspropertyentries);
+
 static inline ElementId elementId(const std::string& name)
 {
-    auto it = elementmap.find(name);
-    if(it == elementmap.end())
-        return ElementId::Unknown;
-
-    return it->second;
+    return elementmap.find(name, ElementId::Unknown);
 }
 
 static inline PropertyId cssPropertyId(const std::string& name)
 {
-    auto it = csspropertymap.find(name);
-    if(it == csspropertymap.end())
-        return PropertyId::Unknown;
-
-    return it->second;
+    return csspropertymap.find(name, PropertyId::Unknown);
 }
 
 static inline PropertyId propertyId(const std::string& name)
 {
-    auto it = propertymap.find(name);
-    if(it == propertymap.end())
+    auto id = propertymap.find(name, PropertyId::Unknown);
+    if(id == PropertyId::Unknown)
         return cssPropertyId(name);
 
-    return it->second;
+    return id;
 }
 
 #define IS_STARTNAMECHAR(c) (IS_ALPHA(c) ||  (c) == '_' || (c) == ':')
@@ -1413,26 +1412,225 @@ bool CSSParser::parseSimpleSelector(const char*& ptr, const char* end, SimpleSel
     return true;
 }
 
+void AncestorFilter::add(std::uint32_t hash)
+{
+    auto& first = m_counters[hash & (Size - 1)];
+    auto& second = m_counters[(hash >> 16) & (Size - 1)];
+    if(first < 0xFF) ++first;
+    if(second < 0xFF) ++second;
+}
+
+void AncestorFilter::remove(std::uint32_t hash)
+{
+    auto& first = m_counters[hash & (Size - 1)];
+    auto& second = m_counters[(hash >> 16) & (Size - 1)];
+    if(first < 0xFF) --first;
+    if(second < 0xFF) --second;
+}
+
+bool AncestorFilter::mayContain(std::uint32_t hash) const
+{
+    return m_counters[hash & (Size - 1)] && m_counters[(hash >> 16) & (Size - 1)];
+}
+
+static std::uint32_t tagHash(ElementId id)
+{
+    return (static_cast<std::uint32_t>(id) + 1) * 0x9E3779B1u;
+}
+
+static std::uint32_t idHash(const char* data, std::size_t length)
+{
+    return hashName(data, length) ^ 0x5BD1E995u;
+}
+
+static std::uint32_t classHash(const char* data, std::size_t length)
+{
+    return hashName(data, length) ^ 0x27D4EB2Du;
+}
+
+template<typename Callback>
+static void forEachClassName(const std::string& value, Callback callback)
+{
+    auto ptr = value.data();
+    auto end = ptr + value.size();
+    while(ptr < end)
+    {
+        auto start = ptr;
+        while(ptr < end && !IS_WS(*ptr))
+            ++ptr;
+
+        if(start < ptr)
+            callback(start, ptr);
+        Utils::skipWs(ptr, end);
+    }
+}
+
+static bool isClassName(const AttributeSelector& selector)
+{
+    if(selector.id != PropertyId::Class || selector.matchType != AttributeSelector::MatchType::Includes || selector.value.empty())
+        return false;
+
+    return std::none_of(selector.value.begin(), selector.value.end(), [](char ch) { return IS_WS(ch); });
+}
+
+static bool isIdName(const AttributeSelector& selector)
+{
+    return selector.id == PropertyId::Id && selector.matchType == AttributeSelector::MatchType::Equal;
+}
+
 RuleMatchContext::RuleMatchContext(const std::vector<Rule>& rules)
 {
+    std::size_t position = 0;
     for(auto& rule : rules)
         for(auto& selector : rule.selectors)
-             m_selectors.emplace(selector.specificity, std::make_pair(&selector, &rule.declarations));
+            addRule(&selector, &rule.declarations, position++);
+}
+
+void RuleMatchContext::addRule(const Selector* selector, const PropertyList* declarations, std::size_t position)
+{
+    if(selector->simpleSelectors.empty())
+        return;
+
+    RuleData rule{selector, declarations, position, {}};
+
+    // Compounds reached through descendant or child combinators must match an
+    // ancestor, so their tag, id and class hashes can be checked against the
+    // ancestor filter before walking the tree. Sibling combinators end this.
+    std::size_t count = 0;
+    auto addHash = [&](std::uint32_t hash) {
+        if(count < rule.ancestorHashes.size())
+            rule.ancestorHashes[count++] = hash ? hash : 1;
+    };
+
+    auto& simpleSelectors = selector->simpleSelectors;
+    for(auto it = simpleSelectors.rbegin() + 1;it != simpleSelectors.rend();++it)
+    {
+        if(it->combinator != SimpleSelector::Combinator::Descendant && it->combinator != SimpleSelector::Combinator::Child)
+            break;
+
+        if(it->id != ElementId::Star)
+            addHash(tagHash(it->id));
+        for(auto& attributeSelector : it->attributeSelectors)
+        {
+            if(isIdName(attributeSelector))
+                addHash(idHash(attributeSelector.value.data(), attributeSelector.value.size()));
+            else if(isClassName(attributeSelector))
+                addHash(classHash(attributeSelector.value.data(), attributeSelector.value.size()));
+        }
+    }
+
+    // Each selector lives in one bucket, keyed by the most specific part of
+    // its rightmost compound: id, then class, then tag.
+    auto& compound = simpleSelectors.back();
+    for(auto& attributeSelector : compound.attributeSelectors)
+    {
+        if(isIdName(attributeSelector))
+        {
+            m_idRules[attributeSelector.value].push_back(rule);
+            return;
+        }
+    }
+
+    for(auto& attributeSelector : compound.attributeSelectors)
+    {
+        if(isClassName(attributeSelector))
+        {
+            m_classRules[attributeSelector.value].push_back(rule);
+            return;
+        }
+    }
+
+    if(compound.id != ElementId::Star)
+    {
+        m_tagRules[compound.id].push_back(rule);
+        return;
+    }
+
+    m_universalRules.push_back(rule);
+}
+
+void RuleMatchContext::pushAncestor(const Element* element)
+{
+    m_ancestorFilter.add(tagHash(element->id));
+    auto& id = element->get(PropertyId::Id);
+    if(!id.empty())
+        m_ancestorFilter.add(idHash(id.data(), id.size()));
+    forEachClassName(element->get(PropertyId::Class), [this](const char* start, const char* end) {
+        m_ancestorFilter.add(classHash(start, end - start));
+    });
+}
+
+void RuleMatchContext::popAncestor(const Element* element)
+{
+    m_ancestorFilter.remove(tagHash(element->id));
+    auto& id = element->get(PropertyId::Id);
+    if(!id.empty())
+        m_ancestorFilter.remove(idHash(id.data(), id.size()));
+    forEachClassName(element->get(PropertyId::Class), [this](const char* start, const char* end) {
+        m_ancestorFilter.remove(classHash(start, end - start));
+    });
+}
+
+void RuleMatchContext::collectMatchingRules(const RuleDataList& rules, const Element* element, std::vector<const RuleData*>& matchedRules) const
+{
+    for(auto& rule : rules)
+    {
+        auto rejected = std::any_of(rule.ancestorHashes.begin(), rule.ancestorHashes.end(), [this](std::uint32_t hash) {
+            return hash && !m_ancestorFilter.mayContain(hash);
+        });
+
+        if(!rejected && selectorMatch(rule.selector, element))
+            matchedRules.push_back(&rule);
+    }
 }
 
 std::vector<const PropertyList*> RuleMatchContext::match(const Element* element) const
 {
-    std::vector<const PropertyList*> declarations;
-    auto it = m_selectors.begin();
-    auto end = m_selectors.end();
-    for(;it != end;++it)
+    std::vector<const RuleData*> matchedRules;
+    auto& id = element->get(PropertyId::Id);
+    if(!id.empty())
     {
-        auto& value = it->second;
-        if(!selectorMatch(std::get<0>(value), element))
-            continue;
-        declarations.push_back(std::get<1>(value));
+        auto it = m_idRules.find(id);
+        if(it != m_idRules.end())
+            collectMatchingRules(it->second, element, matchedRules);
+    }
+
+    auto& className = element->get(PropertyId::Class);
+    if(!className.empty() && !m_classRules.empty())
+    {
+        std::vector<std::string> names;
+        forEachClassName(className, [&names](const char* start, const char* end) {
+            names.emplace_back(start, end);
+        });
+
+        // A class listed twice must not match its rules twice.
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        for(auto& name : names)
+        {
+            auto it = m_classRules.find(name);
+            if(it != m_classRules.end())
+                collectMatchingRules(it->second, element, matchedRules);
+        }
     }
 
+    auto it = m_tagRules.find(element->id);
+    if(it != m_tagRules.end())
+        collectMatchingRules(it->second, element, matchedRules);
+    collectMatchingRules(m_universalRules, element, matchedRules);
+
+    // Declarations are applied in increasing specificity, and in source order
+    // for equal specificity, so later rules win ties.
+    std::sort(matchedRules.begin(), matchedRules.end(), [](const RuleData* a, const RuleData* b) {
+        if(a->selector->specificity != b->selector->specificity)
+            return a->selector->specificity < b->selector->specificity;
+        return a->position < b->position;
+    });
+
+    std::vector<const PropertyList*> declarations;
+    declarations.reserve(matchedRules.size());
+    for(auto rule : matchedRules)
+        declarations.push_back(rule->declarations);
     return declarations;
 }
 
@@ -1589,7 +1787,7 @@ bool RuleMatchContext::pseudoClassMatch(const PseudoClass& pseudo, const Element
         {
             if(sibling->id == element->id)
                 return false;
-            sibling = element->previousSibling();
+            sibling = sibling->previousSibling();
         }
 
         return true;
@@ -1602,7 +1800,7 @@ bool RuleMatchContext::pseudoClassMatch(const PseudoClass& pseudo, const Element
         {
             if(sibling->id == element->id)
                 return false;
-            sibling = element->nextSibling();
+            sibling = sibling->nextSibling();
         }
 
         return true;
@@ -1611,51 +1809,51 @@ bool RuleMatchContext::pseudoClassMatch(const PseudoClass& pseudo, const Element
     return false;
 }
 
-static inline std::unique_ptr<Element> createElement(ElementId id)
+static inline Element* createElement(MemoryArena* arena, ElementId id)
 {
     switch(id) {
     case ElementId::Svg:
-        return std::make_unique<SVGElement>();
+        return arena->create<SVGElement>();
     case ElementId::Path:
-        return std::make_unique<PathElement>();
+        return arena->create<PathElement>();
     case ElementId::G:
-        return std::make_unique<GElement>();
+        return arena->create<GElement>();
     case ElementId::Rect:
-        return std::make_unique<RectElement>();
+        return arena->create<RectElement>();
     case ElementId::Circle:
-        return std::make_unique<CircleElement>();
+        return arena->create<CircleElement>();
     case ElementId::Ellipse:
-        return std::make_unique<EllipseElement>();
+        return arena->create<EllipseElement>();
     case ElementId::Line:
-        return std::make_unique<LineElement>();
+        return arena->create<LineElement>();
     case ElementId::Defs:
-        return std::make_unique<DefsElement>();
+        return arena->create<DefsElement>();
     case ElementId::Polygon:
-        return std::make_unique<PolygonElement>();
+        return arena->create<PolygonElement>();
     case ElementId::Polyline:
-        return std::make_unique<PolylineElement>();
+        return arena->create<PolylineElement>();
     case ElementId::Stop:
-        return std::make_unique<StopElement>();
+        return arena->create<StopElement>();
     case ElementId::LinearGradient:
-        return std::make_unique<LinearGradientElement>();
+        return arena->create<LinearGradientElement>();
     case ElementId::RadialGradient:
-        return std::make_unique<RadialGradientElement>();
+        return arena->create<RadialGradientElement>();
     case ElementId::Symbol:
-        return std::make_unique<SymbolElement>();
+        return arena->create<SymbolElement>();
     case ElementId::Use:
-        return std::make_unique<UseElement>();
+        return arena->create<UseElement>();
     case ElementId::Pattern:
-        return std::make_unique<PatternElement>();
+        return arena->create<PatternElement>();
     case ElementId::Mask:
-        return std::make_unique<MaskElement>();
+        return arena->create<MaskElement>();
     case ElementId::ClipPath:
-        return std::make_unique<ClipPathElement>();
+        return arena->create<ClipPathElement>();
     case ElementId::SolidColor:
-        return std::make_unique<SolidColorElement>();
+        return arena->create<SolidColorElement>();
     case ElementId::Marker:
-        return std::make_unique<MarkerElement>();
+        return arena->create<MarkerElement>();
     case ElementId::Style:
-        return std::make_unique<StyleElement>();
+        return arena->create<StyleElement>();
     default:
         break;
     }
@@ -1668,14 +1866,15 @@ static inline bool decodeText(const char* ptr, const char* end, std::string& val
     value.clear();
     while(ptr < end)
     {
-        auto ch = *ptr;
-        ++ptr;
-        if(ch != '&')
+        auto start = ptr;
+        if(!Utils::skipUntil(ptr, end, '&'))
         {
-            value.push_back(ch);
-            continue;
+            value.append(start, ptr);
+            break;
         }
 
+        value.append(start, ptr);
+        ++ptr;
         if(Utils::skipDesc(ptr, end, '#'))
         {
             int base = 10;
@@ -1778,6 +1977,22 @@ ParseDocument::~ParseDocument()
 {
 }
 
+static void applyRules(RuleMatchContext& context, Element* element)
+{
+    auto declarations = context.match(element);
+    for(auto& declaration : declarations)
+        element->properties.add(*declaration);
+
+    context.pushAncestor(element);
+    for(auto& child : element->children)
+    {
+        if(!child->isText())
+            applyRules(context, static_cast<Element*>(child));
+    }
+
+    context.popAncestor(element);
+}
+
 bool ParseDocument::parse(const char* data, std::size_t size)
 {
     auto ptr = data;
@@ -1929,14 +2144,13 @@ bool ParseDocument::parse(const char* data, std::size_t size)
                 if(id != ElementId::Svg)
                     return false;
 
-                m_rootElement = std::make_unique<SVGElement>();
-                element = m_rootElement.get();
+                m_rootElement = m_arena.create<SVGElement>();
+                element = m_rootElement;
             }
             else
             {
-                auto child = createElement(id);
-                element = child.get();
-                current->addChild(std::move(child));
+                element = createElement(&m_arena, id);
+                current->addChild(element);
             }
         }
 
@@ -1956,10 +2170,7 @@ bool ParseDocument::parse(const char* data, std::size_t size)
             ++ptr;
             Utils::skipWs(ptr, end);
             start = ptr;
-            while(ptr < end && *ptr != quote)
-                ++ptr;
-
-            if(ptr >= end || *ptr != quote)
+            if(!Utils::skipUntil(ptr, end, quote))
                 return false;
 
             auto id = element ? propertyId(name) : PropertyId::Unknown;
@@ -2015,18 +2226,10 @@ bool ParseDocument::parse(const char* data, std::size_t size)
     if(!rules.empty())
     {
         RuleMatchContext context(rules);
-        m_rootElement->transverse([&context](Node* node) {
-            if(node->isText())
-                return false;
-
-            auto element = static_cast<Element*>(node);
-            auto declarations = context.match(element);
-            for(auto& declaration : declarations)
-                element->properties.add(*declaration);
-            return false;
-        });
+        applyRules(context, m_rootElement);
     }
 
+    m_rootElement->cascade();
     return true;
 }
 
@@ -2039,9 +2242,9 @@ Element* ParseDocument::getElementById(const std::string& id) const
     return it->second;
 }
 
-std::unique_ptr<LayoutSymbol> ParseDocument::layout() const
+LayoutSymbol* ParseDocument::layout(MemoryArena* arena) const
 {
-    return m_rootElement->layoutDocument(this);
+    return m_rootElement->layoutDocument(this, arena);
 }
 
 } // namespace lunasvg
@@ -2,6 +2,8 @@
 #define PARSER_H
 
 #include <map>
+#include <array>
+#include <cstdint>
 
 #include "property.h"
 #include "element.h"
@@ -132,6 +134,21 @@ struct Rule
     PropertyList declarations;
 };
 
+// Counting Bloom filter over the tag, id and class hashes of the ancestors
+// of the element being matched. Saturated counters are never decremented,
+// so the filter can only answer "maybe present" too often, never too rarely.
+class AncestorFilter
+{
+public:
+    void add(std::uint32_t hash);
+    void remove(std::uint32_t hash);
+    bool mayContain(std::uint32_t hash) const;
+
+private:
+    static const std::size_t Size = 1 << 12;
+    std::array<std::uint8_t, Size> m_counters{};
+};
+
 class RuleMatchContext
 {
 public:
@@ -139,14 +156,33 @@ public:
 
     std::vector<const PropertyList*> match(const Element* element) const;
 
+    void pushAncestor(const Element* element);
+    void popAncestor(const Element* element);
+
 private:
+    struct RuleData
+    {
+        const Selector* selector;
+        const PropertyList* declarations;
+        std::size_t position;
+        std::array<std::uint32_t, 4> ancestorHashes;
+    };
+
+    using RuleDataList = std::vector<RuleData>;
+
+    void addRule(const Selector* selector, const PropertyList* declarations, std::size_t position);
+    void collectMatchingRules(const RuleDataList& rules, const Element* element, std::vector<const RuleData*>& matchedRules) const;
     bool selectorMatch(const Selector* selector, const Element* element) const;
     bool simpleSelectorMatch(const SimpleSelector& selector, const Element* element) const;
     bool attributeSelectorMatch(const AttributeSelector& selector, const Element* element) const;
     bool pseudoClassMatch(const PseudoClass& pseudo, const Element* element) const;
 
 private:
-    std::multimap<int, std::pair<const Selector*, const PropertyList*>, std::less<int>> m_selectors;
+    std::map<std::string, RuleDataList> m_idRules;
+    std::map<std::string, RuleDataList> m_classRules;
+    std::map<ElementId, RuleDataList> m_tagRules;
+    RuleDataList m_universalRules;
+    AncestorFilter m_ancestorFilter;
 };
 
 class CSSParser
@@ -180,12 +216,13 @@ public:
 
     bool parse(const char* data, std::size_t size);
 
-    SVGElement* rootElement() const { return m_rootElement.get(); }
+    SVGElement* rootElement() const { return m_rootElement; }
     Element* getElementById(const std::string& id) const;
-    std::unique_ptr<LayoutSymbol> layout() const;
+    LayoutSymbol* layout(MemoryArena* arena) const;
 
 private:
-    std::unique_ptr<SVGElement> m_rootElement;
+    MemoryArena m_arena;
+    SVGElement* m_rootElement{nullptr};
     std::map<std::string, Element*> m_idCache;
 };
 
@@ -0,0 +1,185 @@
+#include "parserutils.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LUNASVG_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(LUNASVG_HAS_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LUNASVG_HAS_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <atomic>
+
+namespace lunasvg {
+
+namespace Utils {
+
+static inline int firstBit(std::uint32_t mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static const char* findCharScalar(const char* ptr, const char* end, char ch)
+{
+    while(ptr < end && *ptr != ch)
+        ++ptr;
+
+    return ptr;
+}
+
+static const char* findNonWsScalar(const char* ptr, const char* end)
+{
+    while(ptr < end && IS_WS(*ptr))
+        ++ptr;
+
+    return ptr;
+}
+
+#ifdef LUNASVG_HAS_SSE2
+static inline __m128i wsMask16(__m128i chunk)
+{
+    auto ws = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')));
+    ws = _mm_or_si128(ws, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+    return _mm_or_si128(ws, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+}
+
+static const char* findCharSSE2(const char* ptr, const char* end, char ch)
+{
+    auto needle = _mm_set1_epi8(ch);
+    while(end - ptr >= 16)
+    {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+        auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if(mask != 0)
+            return ptr + firstBit(mask);
+        ptr += 16;
+    }
+
+    return findCharScalar(ptr, end, ch);
+}
+
+static const char* findNonWsSSE2(const char* ptr, const char* end)
+{
+    while(end - ptr >= 16)
+    {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+        auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(wsMask16(chunk))) ^ 0xFFFFu;
+        if(mask != 0)
+            return ptr + firstBit(mask);
+        ptr += 16;
+    }
+
+    return findNonWsScalar(ptr, end);
+}
+#endif
+
+#ifdef LUNASVG_HAS_AVX2
+__attribute__((target("avx2")))
+static const char* findCharAVX2(const char* ptr, const char* end, char ch)
+{
+    auto needle = _mm256_set1_epi8(ch);
+    while(end - ptr >= 32)
+    {
+        auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+        auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if(mask != 0)
+            return ptr + firstBit(mask);
+        ptr += 32;
+    }
+
+    return findCharSSE2(ptr, end, ch);
+}
+
+__attribute__((target("avx2")))
+static const char* findNonWsAVX2(const char* ptr, const char* end)
+{
+    while(end - ptr >= 32)
+    {
+        auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+        auto ws = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t')));
+        ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+        ws = _mm256_or_si256(ws, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')));
+        auto mask = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(ws));
+        if(mask != 0)
+            return ptr + firstBit(mask);
+        ptr += 32;
+    }
+
+    return findNonWsSSE2(ptr, end);
+}
+
+static bool hasAVX2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+static const char* findCharResolve(const char* ptr, const char* end, char ch);
+static const char* findNonWsResolve(const char* ptr, const char* end);
+
+using FindCharFunc = const char*(*)(const char*, const char*, char);
+using FindNonWsFunc = const char*(*)(const char*, const char*);
+
+// Both pointers start at a resolver that picks the widest kernel the CPU
+// supports on first use, so there is no static initializer to run.
+static std::atomic<FindCharFunc> findCharImpl{findCharResolve};
+static std::atomic<FindNonWsFunc> findNonWsImpl{findNonWsResolve};
+
+static void resolveKernels()
+{
+#if defined(LUNASVG_HAS_AVX2)
+    if(hasAVX2())
+    {
+        findCharImpl.store(findCharAVX2, std::memory_order_relaxed);
+        findNonWsImpl.store(findNonWsAVX2, std::memory_order_relaxed);
+        return;
+    }
+#endif
+
+#if defined(LUNASVG_HAS_SSE2)
+    findCharImpl.store(findCharSSE2, std::memory_order_relaxed);
+    findNonWsImpl.store(findNonWsSSE2, std::memory_order_relaxed);
+#else
+    findCharImpl.store(findCharScalar, std::memory_order_relaxed);
+    findNonWsImpl.store(findNonWsScalar, std::memory_order_relaxed);
+#endif
+}
+
+static const char* findCharResolve(const char* ptr, const char* end, char ch)
+{
+    resolveKernels();
+    return findCharImpl.load(std::memory_order_relaxed)(ptr, end, ch);
+}
+
+static const char* findNonWsResolve(const char* ptr, const char* end)
+{
+    resolveKernels();
+    return findNonWsImpl.load(std::memory_order_relaxed)(ptr, end);
+}
+
+const char* findChar(const char* ptr, const char* end, char ch)
+{
+    return findCharImpl.load(std::memory_order_relaxed)(ptr, end, ch);
+}
+
+const char* findNonWs(const char* ptr, const char* end)
+{
+    return findNonWsImpl.load(std::memory_order_relaxed)(ptr, end);
+}
+
+} // namespace Utils
+
+} // namespace lunasvg
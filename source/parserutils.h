@@ -2,6 +2,8 @@
 #define PARSERUTILS_H
 
 #include <cstring>
+#include <cstdint>
+#include <cstddef>
 #include <cmath>
 #include <limits>
 #include <string>
@@ -15,6 +17,10 @@ namespace lunasvg {
 
 namespace Utils {
 
+// Vectorized scans over [ptr, end); both return end when nothing is found.
+const char* findChar(const char* ptr, const char* end, char ch);
+const char* findNonWs(const char* ptr, const char* end);
+
 inline const char* rtrim(const char* start, const char* end)
 {
     while(end > start && IS_WS(end[-1]))
@@ -60,15 +66,13 @@ inline bool skipDesc(const char*& ptr, const char* end, const char* data)
 
 inline bool skipUntil(const char*& ptr, const char* end, const char ch)
 {
-    while(ptr < end && *ptr != ch)
-        ++ptr;
-
+    ptr = findChar(ptr, end, ch);
     return ptr < end;
 }
 
 inline bool skipUntil(const char*& ptr, const char* end, const char* data)
 {
-    while(ptr < end)
+    while(skipUntil(ptr, end, data[0]))
     {
         auto start = ptr;
         if(skipDesc(start, end, data))
@@ -101,8 +105,8 @@ inline bool readUntil(const char*& ptr, const char* end, const char* data, std::
 
 inline bool skipWs(const char*& ptr, const char* end)
 {
-    while(ptr < end && IS_WS(*ptr))
-       ++ptr;
+    if(ptr < end && IS_WS(*ptr) && ++ptr < end && IS_WS(*ptr))
+        ptr = findNonWs(ptr, end);
 
     return ptr < end;
 }
@@ -233,7 +237,7 @@ inline bool parseNumber(const char*& ptr, const char* end, T& number)
     }
 
     if(ptr < end && (*ptr == 'e' || *ptr == 'E')
-       && (ptr[1] != 'x' && ptr[1] != 'm'))
+       && (ptr + 1 == end || (ptr[1] != 'x' && ptr[1] != 'm')))
     {
         ++ptr;
         if(ptr < end && *ptr == '+')
@@ -262,6 +266,100 @@ inline bool parseNumber(const char*& ptr, const char* end, T& number)
 
 } // namespace Utils
 
+template<typename T>
+struct NameEntry
+{
+    template<std::size_t N>
+    constexpr NameEntry(const char(&name)[N], T value)
+        : name(name), length(N - 1), value(value)
+    {}
+
+    const char* name;
+    std::size_t length;
+    T value;
+};
+
+constexpr std::uint32_t hashName(const char* data, std::size_t length)
+{
+    std::uint32_t hash = 2166136261u;
+    for(std::size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+// Perfect hash table over a fixed set of names, built entirely at compile time.
+// Each name is hashed once; the constructor then searches for an odd multiplier
+// whose multiply-shift maps every hash to a distinct slot, so a lookup costs one
+// hash, one slot read and one string compare.
+template<typename T, std::size_t N, std::size_t Size>
+class NameTable
+{
+public:
+    static_assert(N < 255, "too many entries for 8-bit slots");
+    static_assert((Size & (Size - 1)) == 0 && Size >= N, "slot count must be a power of two");
+
+    constexpr NameTable(const NameEntry<T>(&entries)[N])
+        : m_entries(entries)
+    {
+        while((std::size_t(1) << (32 - m_shift)) < Size)
+            --m_shift;
+        for(std::size_t i = 0; i < N; ++i)
+            m_hashes[i] = hashName(entries[i].name, entries[i].length);
+        while(!build())
+            m_multiplier += 0x9E3779B8u;
+    }
+
+    T find(const char* data, std::size_t length, T defaultValue) const
+    {
+        auto hash = hashName(data, length);
+        auto slot = m_slots[slotIndex(hash)];
+        if(slot == 0 || m_hashes[slot - 1] != hash)
+            return defaultValue;
+
+        auto& entry = m_entries[slot - 1];
+        if(entry.length != length || std::memcmp(entry.name, data, length) != 0)
+            return defaultValue;
+
+        return entry.value;
+    }
+
+    T find(const std::string& name, T defaultValue) const { return find(name.data(), name.size(), defaultValue); }
+
+private:
+    constexpr std::size_t slotIndex(std::uint32_t hash) const
+    {
+        return static_cast<std::uint32_t>(hash * m_multiplier) >> m_shift;
+    }
+
+    constexpr bool build()
+    {
+        for(std::size_t i = 0; i < N; ++i)
+        {
+            auto index = slotIndex(m_hashes[i]);
+            if(m_slots[index] != 0)
+            {
+                while(i > 0)
+                    m_slots[slotIndex(m_hashes[--i])] = 0;
+                return false;
+            }
+
+            m_slots[index] = static_cast<std::uint8_t>(i + 1);
+        }
+
+        return true;
+    }
+
+    const NameEntry<T>* m_entries;
+    std::uint32_t m_multiplier{0x9E3779B1u};
+    std::uint32_t m_shift{32};
+    std::uint32_t m_hashes[N]{};
+    std::uint8_t m_slots[Size]{};
+};
+
 } // namespace lunasvg
 
 #endif // PARSERUTILS_H
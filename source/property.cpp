@@ -539,6 +539,202 @@ void PathIterator::next()
     m_index += 1;
 }
 
+static bool fuzzyCompare(double a, double b, double scale)
+{
+    return std::abs(a - b) <= 1e-9 * scale;
+}
+
+// Radii and corners are recovered by subtraction, so the rebuilt path may be
+// off by rounding from the one the element generated.
+static bool matchesPath(const Path& path, const Path& expected)
+{
+    if(path.commands() != expected.commands())
+        return false;
+
+    const auto& a = path.points();
+    const auto& b = expected.points();
+    for(std::size_t i = 0;i < a.size();i++)
+    {
+        auto scale = std::abs(b[i].x) + std::abs(b[i].y) + 1.0;
+        if(!fuzzyCompare(a[i].x, b[i].x, scale) || !fuzzyCompare(a[i].y, b[i].y, scale))
+            return false;
+    }
+
+    return true;
+}
+
+// Curves are judged by their control points: a closed curve whose control
+// polygon is convex is convex itself, as no line crosses a bezier segment
+// more often than its control polygon. The polygon is convex when it always
+// turns the same way and its edges change direction at most twice along
+// each axis, which rules out outlines that wind around more than once.
+static bool isConvex(const std::vector<Point>& points)
+{
+    auto sign = [](double value) { return (value > 0.0) - (value < 0.0); };
+
+    int turn = 0;
+    int xFlips = 0, yFlips = 0;
+    int xFirst = 0, yFirst = 0;
+    int xLast = 0, yLast = 0;
+    auto last = points.front();
+    Point first, previous;
+    bool hasEdge = false;
+    auto addTurn = [&](const Point& a, const Point& b) {
+        auto cross = sign(a.x * b.y - a.y * b.x);
+        if(cross == 0)
+            return true;
+        if(turn != 0 && cross != turn)
+            return false;
+        turn = cross;
+        return true;
+    };
+
+    auto addEdge = [&](const Point& point) {
+        Point edge(point.x - last.x, point.y - last.y);
+        if(edge.x == 0.0 && edge.y == 0.0)
+            return true;
+
+        if(hasEdge && !addTurn(previous, edge))
+            return false;
+        if(!hasEdge)
+            first = edge;
+
+        auto xSign = sign(edge.x);
+        if(xSign != 0)
+        {
+            if(xFirst == 0) xFirst = xSign;
+            if(xLast != 0 && xSign != xLast) xFlips++;
+            xLast = xSign;
+        }
+
+        auto ySign = sign(edge.y);
+        if(ySign != 0)
+        {
+            if(yFirst == 0) yFirst = ySign;
+            if(yLast != 0 && ySign != yLast) yFlips++;
+            yLast = ySign;
+        }
+
+        previous = edge;
+        hasEdge = true;
+        last = point;
+        return true;
+    };
+
+    for(std::size_t i = 1;i < points.size();i++)
+    {
+        if(!addEdge(points[i]))
+            return false;
+    }
+
+    // The outline is closed back to its first point, whose corner joins the
+    // closing edge to the first one.
+    if(!addEdge(points.front()) || (hasEdge && !addTurn(previous, first)))
+        return false;
+
+    if(xLast != xFirst) xFlips++;
+    if(yLast != yFirst) yFlips++;
+    return xFlips <= 2 && yFlips <= 2;
+}
+
+ShapeInfo::ShapeInfo(const Path& path)
+{
+    classify(path);
+    if(kind != ShapeKind::Path)
+        return;
+
+    const auto& points = path.points();
+    coords.reserve(points.size() * 2);
+    for(const auto& point : points)
+    {
+        coords.push_back(static_cast<float>(point.x));
+        coords.push_back(static_cast<float>(point.y));
+    }
+}
+
+void ShapeInfo::classify(const Path& path)
+{
+    const auto& commands = path.commands();
+    if(commands.empty() || commands.front() != PathCommand::MoveTo)
+        return;
+
+    for(std::size_t i = 1;i < commands.size();i++)
+    {
+        if(commands[i] == PathCommand::MoveTo)
+            return;
+        if(commands[i] == PathCommand::Close && i + 1 < commands.size())
+            return;
+    }
+
+    singleContour = true;
+    convex = isConvex(path.points());
+    if(!convex)
+        return;
+
+    const auto& p = path.points();
+    if(p.size() == 5 && commands.size() == 6 && commands.back() == PathCommand::Close)
+    {
+        // Path::rect without radii: the corners clockwise from the top left
+        // and back. No radii are involved, so this one compares exactly.
+        auto x = p[0].x;
+        auto y = p[0].y;
+        auto right = p[1].x;
+        auto bottom = p[2].y;
+        if(right <= x || bottom <= y || p[1].y != y || p[2].x != right || p[3].x != x || p[3].y != bottom || p[4].x != x || p[4].y != y)
+            return;
+
+        kind = ShapeKind::Rect;
+        box = Rect{x, y, right - x, bottom - y};
+    }
+    else if(p.size() == 13)
+    {
+        auto cx = p[0].x;
+        auto cy = p[3].y;
+        auto rx = p[3].x - cx;
+        auto ry = cy - p[0].y;
+        if(rx <= 0.0 || ry <= 0.0)
+            return;
+
+        Path expected;
+        expected.ellipse(cx, cy, rx, ry);
+        if(!matchesPath(path, expected))
+            return;
+
+        if(fuzzyCompare(rx, ry, rx + ry))
+            ry = rx;
+
+        kind = ShapeKind::Ellipse;
+        box = Rect{cx - rx, cy - ry, rx * 2.0, ry * 2.0};
+        this->rx = rx;
+        this->ry = ry;
+    }
+    else if(p.size() == 17)
+    {
+        auto x = p[0].x;
+        auto y = p[3].y;
+        auto rx = p[3].x - x;
+        auto ry = p[0].y - y;
+        auto w = p[7].x - x;
+        auto h = p[11].y - y;
+        if(w <= 0.0 || h <= 0.0 || rx < 0.0 || ry < 0.0)
+            return;
+
+        Path expected;
+        expected.rect(x, y, w, h, rx, ry);
+        if(!matchesPath(path, expected))
+            return;
+
+        // The native primitive has circular corners only.
+        if(!fuzzyCompare(rx, ry, rx + ry))
+            return;
+
+        kind = ShapeKind::RoundedRect;
+        box = Rect{x, y, w, h};
+        this->rx = rx;
+        this->ry = rx;
+    }
+}
+
 const Length Length::Unknown{0, LengthUnits::Unknown};
 const Length Length::Zero{0, LengthUnits::Number};
 const Length Length::One{1, LengthUnits::Number};
@@ -133,6 +133,7 @@ public:
 
     bool empty() const { return w <= 0.0 || h <= 0.0; }
     bool valid() const { return w >= 0.0 && h >= 0.0; }
+    bool contains(const Rect& rect) const { return x <= rect.x && y <= rect.y && x + w >= rect.x + rect.w && y + h >= rect.y + rect.h; }
 
     static const Rect Empty;
     static const Rect Invalid;
@@ -240,6 +241,38 @@ private:
    unsigned int m_index{0};
 };
 
+enum class ShapeKind
+{
+    Path,
+    Rect,
+    RoundedRect,
+    Ellipse
+};
+
+// What a path turns out to be, worked out once at layout so a canvas can
+// draw it with a primitive or take a convex-only fill route. The primitive
+// kinds are recognized from the exact output of Path::rect and Path::ellipse,
+// and carry their box and radii. Other paths keep their points as floats,
+// the precision the vg backend records them in.
+class ShapeInfo
+{
+public:
+    ShapeInfo() = default;
+    explicit ShapeInfo(const Path& path);
+
+public:
+    ShapeKind kind{ShapeKind::Path};
+    Rect box;
+    double rx{0};
+    double ry{0};
+    bool singleContour{false};
+    bool convex{false};
+    std::vector<float> coords;
+
+private:
+    void classify(const Path& path);
+};
+
 enum class LengthUnits
 {
     Unknown,
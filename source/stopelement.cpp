@@ -10,8 +10,9 @@ StopElement::StopElement()
 
 double StopElement::offset() const
 {
-    auto& value = get(PropertyId::Offset);
-    return Parser::parseNumberPercentage(value, 0.0);
+    return getParsed(PropertyId::Offset, [](const std::string& value) {
+        return Parser::parseNumberPercentage(value, 0.0);
+    });
 }
 
 Color StopElement::stopColorWithOpacity() const
@@ -21,9 +22,9 @@ Color StopElement::stopColorWithOpacity() const
     return color;
 }
 
-std::unique_ptr<Node> StopElement::clone() const
+Node* StopElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<StopElement>();
+    return cloneElement<StopElement>(arena);
 }
 
 } // namespace lunasvg
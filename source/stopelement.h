@@ -13,7 +13,7 @@ public:
     double offset() const;
     Color stopColorWithOpacity() const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 } // namespace lunasvg
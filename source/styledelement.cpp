@@ -8,130 +8,159 @@ StyledElement::StyledElement(ElementId id)
 {
 }
 
+// Only plain colors are kept parsed: currentColor resolves against the
+// element asking for the value, so it is re-parsed on every read.
+struct ColorValue
+{
+    Color color;
+    bool plain;
+};
+
+static bool usesCurrentColor(const std::string& value)
+{
+    return value.find("currentColor") != std::string::npos;
+}
+
 Paint StyledElement::fill() const
 {
-    auto& value = find(PropertyId::Fill);
-    return Parser::parsePaint(value, this, Color::Black);
+    if(style->fillCurrentColor)
+        return Parser::parsePaint(find(PropertyId::Fill), this, Color::Black);
+    return style->fill;
 }
 
 Paint StyledElement::stroke() const
 {
-    auto& value = find(PropertyId::Stroke);
-    return Parser::parsePaint(value, this, Color::Transparent);
+    if(style->strokeCurrentColor)
+        return Parser::parsePaint(find(PropertyId::Stroke), this, Color::Transparent);
+    return style->stroke;
 }
 
 Color StyledElement::color() const
 {
-    auto& value = find(PropertyId::Color);
-    return Parser::parseColor(value, this, Color::Black);
+    return style->color;
 }
 
 Color StyledElement::stop_color() const
 {
-    auto& value = find(PropertyId::Stop_Color);
-    return Parser::parseColor(value, this, Color::Black);
+    auto color = findParsed(PropertyId::Stop_Color, [](const std::string& value) {
+        if(usesCurrentColor(value))
+            return ColorValue{Color::Transparent, false};
+        return ColorValue{Parser::parseColor(value, nullptr, Color::Black), true};
+    });
+
+    if(!color.plain)
+        return Parser::parseColor(find(PropertyId::Stop_Color), this, Color::Black);
+    return color.color;
 }
 
 Color StyledElement::solid_color() const
 {
-    auto& value = find(PropertyId::Solid_Color);
-    return Parser::parseColor(value, this, Color::Black);
+    auto color = findParsed(PropertyId::Solid_Color, [](const std::string& value) {
+        if(usesCurrentColor(value))
+            return ColorValue{Color::Transparent, false};
+        return ColorValue{Parser::parseColor(value, nullptr, Color::Black), true};
+    });
+
+    if(!color.plain)
+        return Parser::parseColor(find(PropertyId::Solid_Color), this, Color::Black);
+    return color.color;
 }
 
 double StyledElement::opacity() const
 {
-    auto& value = get(PropertyId::Opacity);
-    return Parser::parseNumberPercentage(value, 1.0);
+    return getParsed(PropertyId::Opacity, [](const std::string& value) {
+        return Parser::parseNumberPercentage(value, 1.0);
+    });
 }
 
 double StyledElement::fill_opacity() const
 {
-    auto& value = find(PropertyId::Fill_Opacity);
-    return Parser::parseNumberPercentage(value, 1.0);
+    return style->fill_opacity;
 }
 
 double StyledElement::stroke_opacity() const
 {
-    auto& value = find(PropertyId::Stroke_Opacity);
-    return Parser::parseNumberPercentage(value, 1.0);
+    return style->stroke_opacity;
 }
 
 double StyledElement::stop_opacity() const
 {
-    auto& value = find(PropertyId::Stop_Opacity);
-    return Parser::parseNumberPercentage(value, 1.0);
+    return findParsed(PropertyId::Stop_Opacity, [](const std::string& value) {
+        return Parser::parseNumberPercentage(value, 1.0);
+    });
 }
 
 double StyledElement::solid_opacity() const
 {
-    auto& value = find(PropertyId::Solid_Opacity);
-    return Parser::parseNumberPercentage(value, 1.0);
+    return findParsed(PropertyId::Solid_Opacity, [](const std::string& value) {
+        return Parser::parseNumberPercentage(value, 1.0);
+    });
 }
 
 double StyledElement::stroke_miterlimit() const
 {
-    auto& value = find(PropertyId::Stroke_Miterlimit);
-    return Parser::parseNumber(value, 4.0);
+    return style->stroke_miterlimit;
 }
 
 Length StyledElement::stroke_width() const
 {
-    auto& value = find(PropertyId::Stroke_Width);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::One);
+    return style->stroke_width;
 }
 
 Length StyledElement::stroke_dashoffset() const
 {
-    auto& value = find(PropertyId::Stroke_Dashoffset);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return style->stroke_dashoffset;
 }
 
-LengthList StyledElement::stroke_dasharray() const
+const LengthList& StyledElement::stroke_dasharray() const
 {
-    auto& value = find(PropertyId::Stroke_Dasharray);
-    return Parser::parseLengthList(value, ForbidNegativeLengths);
+    return style->stroke_dasharray;
 }
 
 WindRule StyledElement::fill_rule() const
 {
-    auto& value = find(PropertyId::Fill_Rule);
-    return Parser::parseWindRule(value);
+    return style->fill_rule;
 }
 
 WindRule StyledElement::clip_rule() const
 {
-    auto& value = find(PropertyId::Clip_Rule);
-    return Parser::parseWindRule(value);
+    return style->clip_rule;
 }
 
 LineCap StyledElement::stroke_linecap() const
 {
-    auto& value = find(PropertyId::Stroke_Linecap);
-    return Parser::parseLineCap(value);
+    return style->stroke_linecap;
 }
 
 LineJoin StyledElement::stroke_linejoin() const
 {
-    auto& value = find(PropertyId::Stroke_Linejoin);
-    return Parser::parseLineJoin(value);
+    return style->stroke_linejoin;
 }
 
 Display StyledElement::display() const
 {
-    auto& value = get(PropertyId::Display);
-    return Parser::parseDisplay(value);
+    return getParsed(PropertyId::Display, [](const std::string& value) {
+        return Parser::parseDisplay(value);
+    });
 }
 
 Visibility StyledElement::visibility() const
 {
-    auto& value = find(PropertyId::Visibility);
-    return Parser::parseVisibility(value);
+    return style->visibility;
 }
 
 Overflow StyledElement::overflow() const
 {
-    auto& value = get(PropertyId::Overflow);
-    return Parser::parseOverflow(value, parent == nullptr ? Overflow::Visible : Overflow::Hidden);
+    if(parent == nullptr)
+    {
+        return getParsed(PropertyId::Overflow, [](const std::string& value) {
+            return Parser::parseOverflow(value, Overflow::Visible);
+        });
+    }
+
+    return getParsed(PropertyId::Overflow, [](const std::string& value) {
+        return Parser::parseOverflow(value, Overflow::Hidden);
+    });
 }
 
 std::string StyledElement::clip_path() const
@@ -146,22 +175,19 @@ std::string StyledElement::mask() const
     return Parser::parseUrl(value);
 }
 
-std::string StyledElement::marker_start() const
+const std::string& StyledElement::marker_start() const
 {
-    auto& value = find(PropertyId::Marker_Start);
-    return Parser::parseUrl(value);
+    return style->marker_start;
 }
 
-std::string StyledElement::marker_mid() const
+const std::string& StyledElement::marker_mid() const
 {
-    auto& value = find(PropertyId::Marker_Mid);
-    return Parser::parseUrl(value);
+    return style->marker_mid;
 }
 
-std::string StyledElement::marker_end() const
+const std::string& StyledElement::marker_end() const
 {
-    auto& value = find(PropertyId::Marker_End);
-    return Parser::parseUrl(value);
+    return style->marker_end;
 }
 
 bool StyledElement::isDisplayNone() const
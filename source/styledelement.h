@@ -26,7 +26,7 @@ public:
 
     Length stroke_width() const;
     Length stroke_dashoffset() const;
-    LengthList stroke_dasharray() const;
+    const LengthList& stroke_dasharray() const;
 
     WindRule fill_rule() const;
     WindRule clip_rule() const;
@@ -40,9 +40,9 @@ public:
 
     std::string clip_path() const;
     std::string mask() const;
-    std::string marker_start() const;
-    std::string marker_mid() const;
-    std::string marker_end() const;
+    const std::string& marker_start() const;
+    const std::string& marker_mid() const;
+    const std::string& marker_end() const;
 
     bool isDisplayNone() const;
     bool isOverflowHidden() const;
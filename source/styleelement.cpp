@@ -7,9 +7,9 @@ StyleElement::StyleElement()
 {
 }
 
-std::unique_ptr<Node> StyleElement::clone() const
+Node* StyleElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<StyleElement>();
+    return cloneElement<StyleElement>(arena);
 }
 
 } // namespace lunasvg
@@ -10,7 +10,7 @@ class StyleElement : public Element
 public:
     StyleElement();
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 } // namespace lunasvg
@@ -11,41 +11,47 @@ SVGElement::SVGElement()
 
 Length SVGElement::x() const
 {
-    auto& value = get(PropertyId::X);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::X, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length SVGElement::y() const
 {
-    auto& value = get(PropertyId::Y);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Y, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length SVGElement::width() const
 {
-    auto& value = get(PropertyId::Width);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    return getParsed(PropertyId::Width, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    });
 }
 
 Length SVGElement::height() const
 {
-    auto& value = get(PropertyId::Height);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    return getParsed(PropertyId::Height, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    });
 }
 
 Rect SVGElement::viewBox() const
 {
-    auto& value = get(PropertyId::ViewBox);
-    return Parser::parseViewBox(value);
+    return getParsed(PropertyId::ViewBox, [](const std::string& value) {
+        return Parser::parseViewBox(value);
+    });
 }
 
 PreserveAspectRatio SVGElement::preserveAspectRatio() const
 {
-    auto& value = get(PropertyId::PreserveAspectRatio);
-    return Parser::parsePreserveAspectRatio(value);
+    return getParsed(PropertyId::PreserveAspectRatio, [](const std::string& value) {
+        return Parser::parsePreserveAspectRatio(value);
+    });
 }
 
-std::unique_ptr<LayoutSymbol> SVGElement::layoutDocument(const ParseDocument* document) const
+LayoutSymbol* SVGElement::layoutDocument(const ParseDocument* document, MemoryArena* arena) const
 {
     if(isDisplayNone())
         return nullptr;
@@ -66,17 +72,17 @@ std::unique_ptr<LayoutSymbol> SVGElement::layoutDocument(const ParseDocument* do
     auto viewTranslation = Transform::translated(_x, _y);
     auto viewTransform = preserveAspectRatio.getMatrix(_w, _h, viewBox);
 
-    auto root = std::make_unique<LayoutSymbol>();
+    auto root = arena->create<LayoutSymbol>();
     root->width = _w;
     root->height = _h;
     root->transform = (viewTransform * viewTranslation) * transform();
     root->clip = isOverflowHidden() ? preserveAspectRatio.getClip(_w, _h, viewBox) : Rect::Invalid;
     root->opacity = opacity();
 
-    LayoutContext context(document, root.get());
+    LayoutContext context(document, root, arena);
     root->masker = context.getMasker(mask());
     root->clipper = context.getClipper(clip_path());
-    layoutChildren(&context, root.get());
+    layoutChildren(&context, root);
     return root;
 }
 
@@ -101,7 +107,7 @@ void SVGElement::layout(LayoutContext* context, LayoutContainer* current) const
     auto viewTranslation = Transform::translated(_x, _y);
     auto viewTransform = preserveAspectRatio.getMatrix(_w, _h, viewBox);
 
-    auto symbol = std::make_unique<LayoutSymbol>();
+    auto symbol = context->create<LayoutSymbol>();
     symbol->width = _w;
     symbol->height = _h;
     symbol->transform = (viewTransform * viewTranslation) * transform();
@@ -109,13 +115,13 @@ void SVGElement::layout(LayoutContext* context, LayoutContainer* current) const
     symbol->opacity = opacity();
     symbol->masker = context->getMasker(mask());
     symbol->clipper = context->getClipper(clip_path());
-    layoutChildren(context, symbol.get());
-    current->addChildIfNotEmpty(std::move(symbol));
+    layoutChildren(context, symbol);
+    current->addChildIfNotEmpty(symbol);
 }
 
-std::unique_ptr<Node> SVGElement::clone() const
+Node* SVGElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<SVGElement>();
+    return cloneElement<SVGElement>(arena);
 }
 
 } // namespace lunasvg
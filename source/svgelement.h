@@ -7,6 +7,7 @@ namespace lunasvg {
 
 class ParseDocument;
 class LayoutSymbol;
+class MemoryArena;
 
 class SVGElement : public GraphicsElement
 {
@@ -20,10 +21,10 @@ public:
 
     Rect viewBox() const;
     PreserveAspectRatio preserveAspectRatio() const;
-    std::unique_ptr<LayoutSymbol> layoutDocument(const ParseDocument* document) const;
+    LayoutSymbol* layoutDocument(const ParseDocument* document, MemoryArena* arena) const;
 
     void layout(LayoutContext* context, LayoutContainer* current) const;
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 } // namespace lunasvg
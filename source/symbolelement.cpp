@@ -10,43 +10,49 @@ SymbolElement::SymbolElement()
 
 Length SymbolElement::x() const
 {
-    auto& value = get(PropertyId::X);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::X, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length SymbolElement::y() const
 {
-    auto& value = get(PropertyId::Y);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Y, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length SymbolElement::width() const
 {
-    auto& value = get(PropertyId::Width);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    return getParsed(PropertyId::Width, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    });
 }
 
 Length SymbolElement::height() const
 {
-    auto& value = get(PropertyId::Height);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    return getParsed(PropertyId::Height, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    });
 }
 
 Rect SymbolElement::viewBox() const
 {
-    auto& value = get(PropertyId::ViewBox);
-    return Parser::parseViewBox(value);
+    return getParsed(PropertyId::ViewBox, [](const std::string& value) {
+        return Parser::parseViewBox(value);
+    });
 }
 
 PreserveAspectRatio SymbolElement::preserveAspectRatio() const
 {
-    auto& value = get(PropertyId::PreserveAspectRatio);
-    return Parser::parsePreserveAspectRatio(value);
+    return getParsed(PropertyId::PreserveAspectRatio, [](const std::string& value) {
+        return Parser::parsePreserveAspectRatio(value);
+    });
 }
 
-std::unique_ptr<Node> SymbolElement::clone() const
+Node* SymbolElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<SymbolElement>();
+    return cloneElement<SymbolElement>(arena);
 }
 
 } // namespace lunasvg
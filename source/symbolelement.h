@@ -17,7 +17,7 @@ public:
     Rect viewBox() const;
     PreserveAspectRatio preserveAspectRatio() const;
 
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
 };
 
 } // namespace lunasvg
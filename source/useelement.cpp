@@ -14,26 +14,30 @@ UseElement::UseElement()
 
 Length UseElement::x() const
 {
-    auto& value = get(PropertyId::X);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::X, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length UseElement::y() const
 {
-    auto& value = get(PropertyId::Y);
-    return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    return getParsed(PropertyId::Y, [](const std::string& value) {
+        return Parser::parseLength(value, AllowNegativeLengths, Length::Zero);
+    });
 }
 
 Length UseElement::width() const
 {
-    auto& value = get(PropertyId::Width);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    return getParsed(PropertyId::Width, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    });
 }
 
 Length UseElement::height() const
 {
-    auto& value = get(PropertyId::Height);
-    return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    return getParsed(PropertyId::Height, [](const std::string& value) {
+        return Parser::parseLength(value, ForbidNegativeLengths, Length::HundredPercent);
+    });
 }
 
 std::string UseElement::href() const
@@ -61,39 +65,91 @@ void UseElement::layout(LayoutContext* context, LayoutContainer* current) const
         return;
 
     LayoutBreaker layoutBreaker(context, ref);
-    auto group = std::make_unique<GElement>();
-    group->parent = parent;
-    group->properties = properties;
-
     LengthContext lengthContext(this);
     auto _x = lengthContext.valueForLength(x(), LengthMode::Width);
     auto _y = lengthContext.valueForLength(y(), LengthMode::Height);
 
-    auto transform = get(PropertyId::Transform);
-    transform += "translate(";
-    transform += std::to_string(_x);
-    transform += ' ';
-    transform += std::to_string(_y);
-    transform += ')';
-    group->set(PropertyId::Transform, transform, 0x10);
+    auto instance = context->create<LayoutInstance>();
+    instance->transform = Transform::translated(_x, _y) * transform();
+    instance->opacity = opacity();
+    instance->masker = context->getMasker(mask());
+    instance->clipper = context->getClipper(clip_path());
+    layoutReference(context, ref, instance);
+    if(instance->content)
+        current->addChild(instance);
+}
+
+static const Element* viewportElement(const Element* element)
+{
+    auto parent = element->parent;
+    while(parent && parent->id != ElementId::Svg)
+        parent = parent->parent;
+    return parent;
+}
+
+void UseElement::layoutReference(LayoutContext* context, const Element* ref, LayoutInstance* instance) const
+{
+    // What the referenced subtree lays out to depends only on the style it
+    // inherits, the viewport its percentages resolve against and, for svg and
+    // symbol, the size forwarded by the <use>. The inherited style is keyed by
+    // the parent's style and the inherited properties the <use> declares, so
+    // uses that set the same fill still share one subtree.
+    auto isViewport = ref->id == ElementId::Svg || ref->id == ElementId::Symbol;
+    InstanceKey key{ref, parent->style.get(), std::string{}, viewportElement(this), std::string{}, std::string{}};
+    for(auto& property : properties)
+    {
+        if(!isInheritedProperty(property.id))
+            continue;
+        key.declarations += static_cast<char>(property.id);
+        key.declarations += property.value;
+        key.declarations += '\0';
+    }
+
+    if(isViewport)
+    {
+        key.width = get(PropertyId::Width);
+        key.height = get(PropertyId::Height);
+    }
+
+    if(context->findInstance(key, instance))
+        return;
 
-    if(ref->id == ElementId::Svg || ref->id == ElementId::Symbol)
+    // The cloned elements only carry the cascade, so they live in a scratch
+    // arena dropped on return; the layout objects go to the document.
+    MemoryArena arena;
+    auto group = arena.create<GElement>();
+    group->parent = parent;
+    group->properties = properties;
+    if(isViewport)
     {
-        auto element = ref->cloneElement<SVGElement>();
-        transferWidthAndHeight(element.get());
-        group->addChild(std::move(element));
+        auto element = ref->cloneElement<SVGElement>(&arena);
+        transferWidthAndHeight(element);
+        group->addChild(element);
     }
     else
     {
-        group->addChild(ref->clone());
+        group->addChild(ref->clone(&arena));
     }
 
-    group->layout(context, current);
+    group->cascade();
+
+    auto referenceBreaks = context->referenceBreaks();
+    LayoutGroup container;
+    context->enterInstance();
+    group->layoutChildren(context, &container);
+    context->leaveInstance();
+    instance->content = container.children.back();
+    instance->cacheable = false;
+
+    // A subtree cut short by a reference cycle depends on which <use> chain
+    // reached it, so only complete layouts are shared.
+    if(context->referenceBreaks() == referenceBreaks)
+        context->addInstance(key, instance, instance->content && LayoutInstance::isCacheable(instance->content));
 }
 
-std::unique_ptr<Node> UseElement::clone() const
+Node* UseElement::clone(MemoryArena* arena) const
 {
-    return cloneElement<UseElement>();
+    return cloneElement<UseElement>(arena);
 }
 
 } // namespace lunasvg
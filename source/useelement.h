@@ -5,6 +5,8 @@
 
 namespace lunasvg {
 
+class LayoutInstance;
+
 class UseElement : public GraphicsElement
 {
 public:
@@ -18,7 +20,10 @@ public:
     void transferWidthAndHeight(Element* element) const;
 
     void layout(LayoutContext* context, LayoutContainer* current) const;
-    std::unique_ptr<Node> clone() const;
+    Node* clone(MemoryArena* arena) const;
+
+private:
+    void layoutReference(LayoutContext* context, const Element* ref, LayoutInstance* instance) const;
 };
 
 } // namespace lunasvg